@@ -0,0 +1,205 @@
+/*
+ * Benchmark harness: CPU topology, thread pinning and timing.
+ */
+
+#ifndef BIP_BENCH_H_INCLUDED
+#define BIP_BENCH_H_INCLUDED
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <sched.h>
+
+namespace bench {
+
+using clock = std::chrono::steady_clock;
+
+/*
+ * Logical CPU with its physical core and package
+ */
+struct Cpu {
+    int id;
+    int core;
+    int package;
+};
+
+/*
+ * Where the two threads of each producer/consumer pair run
+ */
+enum class Placement {
+    Unpinned,
+    Siblings,
+    Socket,
+    CrossSocket,
+};
+
+inline const char* name(Placement placement) {
+	switch (placement) {
+	case Placement::Unpinned: return "unpinned";
+	case Placement::Siblings: return "smt-siblings";
+	case Placement::Socket: return "same-socket";
+	case Placement::CrossSocket: return "cross-socket";
+	}
+	return "?";
+}
+
+/*
+ * Returns the CPUs this process may run on
+ */
+inline std::vector<Cpu> topology() {
+	std::vector<Cpu> cpus;
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+		return cpus;
+	}
+	const auto read = [](int cpu, const char* file, int fallback) {
+		std::ifstream in{"/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/" + file};
+		int value = fallback;
+		return in >> value ? value : fallback;
+	};
+	for (int id = 0; id < CPU_SETSIZE; ++id) {
+		if (CPU_ISSET(id, &set)) {
+			cpus.push_back(Cpu{id, read(id, "core_id", id), read(id, "physical_package_id", 0)});
+		}
+	}
+	return cpus;
+}
+
+/*
+ * Choose producer and consumer CPUs for 'pairs' pairs. Returns false if the machine doesn't have enough of them
+ */
+inline bool place(const std::vector<Cpu>& cpus, Placement placement, std::size_t pairs,
+		std::vector<std::pair<int, int>>& out) {
+	out.clear();
+	if (placement == Placement::Unpinned) {
+		out.assign(pairs, std::make_pair(-1, -1));
+		return true;
+	}
+	// Package -> core -> hardware threads.
+	std::map<int, std::map<int, std::vector<int>>> packages;
+	for (const auto& cpu : cpus) {
+		packages[cpu.package][cpu.core].push_back(cpu.id);
+	}
+	switch (placement) {
+	case Placement::Siblings:
+		for (const auto& package : packages) {
+			for (const auto& core : package.second) {
+				if (core.second.size() >= 2) {
+					out.emplace_back(core.second[0], core.second[1]);
+				}
+			}
+		}
+		break;
+	case Placement::Socket:
+		for (const auto& package : packages) {
+			std::vector<int> firsts;
+			for (const auto& core : package.second) {
+				firsts.push_back(core.second[0]);
+			}
+			for (std::size_t i = 0; i + 1 < firsts.size(); i += 2) {
+				out.emplace_back(firsts[i], firsts[i + 1]);
+			}
+		}
+		break;
+	case Placement::CrossSocket:
+		if (packages.size() >= 2) {
+			auto second = std::next(packages.begin());
+			auto core = packages.begin()->second.begin();
+			auto other = second->second.begin();
+			for (; core != packages.begin()->second.end() && other != second->second.end(); ++core, ++other) {
+				out.emplace_back(core->second[0], other->second[0]);
+			}
+		}
+		break;
+	case Placement::Unpinned:
+		break;
+	}
+	if (out.size() < pairs) {
+		return false;
+	}
+	out.resize(pairs);
+	return true;
+}
+
+/*
+ * Pin the calling thread to 'cpu', or leave it alone if 'cpu' is negative
+ */
+inline bool pin(int cpu) {
+	if (cpu < 0) {
+		return true;
+	}
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+/*
+ * Spin until 'count' threads arrived, so that all of them start measuring together
+ */
+class StartLine {
+public:
+    explicit StartLine(std::size_t count) : m_count{count}, m_arrived{0} {}
+
+    inline void arrive();
+
+private:
+    const std::size_t m_count;
+    std::atomic<std::size_t> m_arrived;
+}; // class StartLine
+
+void StartLine::arrive() {
+	m_arrived.fetch_add(1, std::memory_order_acq_rel);
+	while (m_arrived.load(std::memory_order_acquire) < m_count) {
+		std::this_thread::yield();
+	}
+}
+
+/*
+ * Frees what make_aligned() returned
+ */
+template <typename T>
+struct AlignedDelete {
+    void operator()(T* object) const;
+}; // struct AlignedDelete
+
+template <typename T>
+void AlignedDelete<T>::operator()(T* object) const {
+	object->~T();
+	free(object);
+}
+
+template <typename T>
+using aligned_ptr = std::unique_ptr<T, AlignedDelete<T>>;
+
+/*
+ * Construct an over-aligned object on the heap, which C++11 operator new doesn't support
+ */
+template <typename T, typename... Args>
+aligned_ptr<T> make_aligned(Args&&... args) {
+	void* memory = nullptr;
+	if (posix_memalign(&memory, alignof(T), sizeof(T)) != 0) {
+		throw std::bad_alloc{};
+	}
+	return aligned_ptr<T>{new (memory) T(std::forward<Args>(args)...)};
+}
+
+inline double seconds(clock::duration duration) {
+	return std::chrono::duration<double>(duration).count();
+}
+
+} // namespace bench
+
+#endif // BIP_BENCH_H_INCLUDED
@@ -0,0 +1,176 @@
+/*
+ * Hardware performance counters for benchmarks, through perf_event_open.
+ */
+
+#ifndef BIP_BENCH_COUNTERS_H_INCLUDED
+#define BIP_BENCH_COUNTERS_H_INCLUDED
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace bench {
+
+enum class Counter {
+    Cycles,
+    Instructions,
+    L1Misses,
+    LlcMisses,
+    Hitm,
+};
+
+constexpr std::size_t counter_count = 5;
+
+inline const char* name(Counter counter) {
+	switch (counter) {
+	case Counter::Cycles: return "cycles";
+	case Counter::Instructions: return "instr";
+	case Counter::L1Misses: return "L1D miss";
+	case Counter::LlcMisses: return "LLC miss";
+	case Counter::Hitm: return "HITM";
+	}
+	return "?";
+}
+
+/*
+ * User space counts of the calling thread and of every thread it starts after construction,
+ * read once those threads are joined. Counters the kernel or the machine doesn't offer, as is
+ * common in virtual machines, are left unavailable instead of failing.
+ *
+ * There is no generic event for loads hitting a line modified in another core's cache, so HITM is
+ * only counted when BIP_BENCH_HITM holds the raw event code of the CPU, as listed by 'perf list'.
+ */
+class Counters {
+public:
+    Counters();
+    ~Counters();
+
+    Counters(const Counters&) = delete;
+    Counters& operator=(const Counters&) = delete;
+
+    /*
+     * Reset and start counting
+     */
+    inline void start();
+
+    /*
+     * Stop counting and read the values, scaled if the kernel multiplexed the counters
+     */
+    void stop();
+
+    /*
+     * Returns true if 'counter' was opened
+     */
+    inline bool available(Counter counter) const;
+
+    /*
+     * Returns the value of 'counter' read by stop()
+     */
+    inline double value(Counter counter) const;
+
+    /*
+     * Returns why the first unavailable counter failed to open, or an empty string
+     */
+    inline const std::string& error() const;
+
+private:
+    int open(std::uint32_t type, std::uint64_t config);
+
+    std::array<int, counter_count> m_fds;
+    std::array<double, counter_count> m_values;
+    std::string m_error;
+}; // class Counters
+
+} // namespace bench
+
+namespace bench {
+
+inline Counters::Counters() :
+		m_fds{},
+		m_values{},
+		m_error{} {
+	const auto cache = [](std::uint64_t id, std::uint64_t result) {
+		return id | PERF_COUNT_HW_CACHE_OP_READ << 8 | result << 16;
+	};
+	m_fds[static_cast<std::size_t>(Counter::Cycles)] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+	m_fds[static_cast<std::size_t>(Counter::Instructions)] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+	m_fds[static_cast<std::size_t>(Counter::L1Misses)] = open(PERF_TYPE_HW_CACHE,
+			cache(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_RESULT_MISS));
+	m_fds[static_cast<std::size_t>(Counter::LlcMisses)] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+	const auto hitm = getenv("BIP_BENCH_HITM");
+	m_fds[static_cast<std::size_t>(Counter::Hitm)] = hitm ? open(PERF_TYPE_RAW, strtoull(hitm, nullptr, 0)) : -1;
+}
+
+inline Counters::~Counters() {
+	for (const auto fd : m_fds) {
+		if (fd >= 0) {
+			close(fd);
+		}
+	}
+}
+
+void Counters::start() {
+	for (const auto fd : m_fds) {
+		if (fd >= 0) {
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+}
+
+inline void Counters::stop() {
+	for (std::size_t i = 0; i < counter_count; ++i) {
+		m_values[i] = 0;
+		if (m_fds[i] < 0) {
+			continue;
+		}
+		ioctl(m_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+		// Value, time enabled, time running.
+		std::uint64_t read_format[3] = {};
+		if (read(m_fds[i], read_format, sizeof(read_format)) == sizeof(read_format) && read_format[2] != 0) {
+			m_values[i] = static_cast<double>(read_format[0]) * read_format[1] / read_format[2];
+		}
+	}
+}
+
+bool Counters::available(Counter counter) const {
+	return m_fds[static_cast<std::size_t>(counter)] >= 0;
+}
+
+double Counters::value(Counter counter) const {
+	return m_values[static_cast<std::size_t>(counter)];
+}
+
+const std::string& Counters::error() const {
+	return m_error;
+}
+
+inline int Counters::open(std::uint32_t type, std::uint64_t config) {
+	perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = type;
+	attr.config = config;
+	attr.disabled = 1;
+	attr.inherit = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	const auto fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+	if (fd < 0 && m_error.empty()) {
+		m_error = strerror(errno);
+	}
+	return fd;
+}
+
+} // namespace bench
+
+#endif // BIP_BENCH_COUNTERS_H_INCLUDED
@@ -0,0 +1,209 @@
+/*
+ * Variants of the bip::SPSC algorithm for measuring its concurrency design choices.
+ */
+
+#ifndef BIP_BENCH_VARIANTS_H_INCLUDED
+#define BIP_BENCH_VARIANTS_H_INCLUDED
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+#include "BipRelax.h"
+
+namespace bench {
+
+/*
+ * What a thread does when the ring is full or empty
+ */
+enum class Wait {
+    Yield,
+    Spin,
+    Pause,
+};
+
+inline const char* name(Wait wait) {
+	switch (wait) {
+	case Wait::Yield: return "yield";
+	case Wait::Spin: return "spin";
+	case Wait::Pause: return "pause";
+	}
+	return "?";
+}
+
+inline void wait(Wait wait) {
+	switch (wait) {
+	case Wait::Yield:
+		std::this_thread::yield();
+		break;
+	case Wait::Spin:
+		break;
+	case Wait::Pause:
+		bip::relax();
+		break;
+	}
+}
+
+namespace internal {
+
+/*
+ * Shared cursors plus each side's copy of the other side's cursor. Padded keeps the producer's and the
+ * consumer's lines apart, packed shares one line between them
+ */
+template <bool Padded>
+struct VariantCursors;
+
+template <>
+struct VariantCursors<true> {
+    alignas(64) std::atomic<std::size_t> write;
+    std::atomic<std::size_t> last;
+    std::size_t cached_read;
+    alignas(64) std::atomic<std::size_t> read;
+    std::size_t cached_write;
+    char pad[64 - sizeof(std::atomic<std::size_t>) - sizeof(std::size_t)];
+};
+
+template <>
+struct VariantCursors<false> {
+    alignas(64) std::atomic<std::size_t> write;
+    std::atomic<std::size_t> last;
+    std::atomic<std::size_t> read;
+    std::size_t cached_read;
+    std::size_t cached_write;
+};
+
+} // namespace internal
+
+/*
+ * bip::SPSC with its layout, publication ordering and remote cursor caching chosen at compile time.
+ * bip::SPSC itself is padded, acquire/release and uncached
+ */
+template <typename T, bool Padded, bool SeqCst, bool Cached>
+class Variant {
+public:
+    Variant(T* buf, std::size_t size) noexcept;
+
+    Variant(const Variant&) = delete;
+    Variant& operator=(const Variant&) = delete;
+
+    std::size_t put(const T* data, std::size_t size) noexcept;
+    std::size_t get(T* data, std::size_t size) noexcept;
+
+private:
+    static constexpr std::memory_order load_order = SeqCst ? std::memory_order_seq_cst : std::memory_order_acquire;
+    static constexpr std::memory_order store_order = SeqCst ? std::memory_order_seq_cst : std::memory_order_release;
+
+    inline T* reserve(std::size_t& size) noexcept;
+    inline const T* peek(std::size_t& size) noexcept;
+    inline std::size_t free(std::size_t w, std::size_t r) const noexcept;
+
+    T* const m_buf;
+    const std::size_t m_size;
+    internal::VariantCursors<Padded> m_cursors;
+}; // class Variant
+
+} // namespace bench
+
+namespace bench {
+
+template <typename T, bool Padded, bool SeqCst, bool Cached>
+Variant<T, Padded, SeqCst, Cached>::Variant(T* buf, std::size_t size) noexcept :
+		m_buf{buf},
+		m_size{size},
+		m_cursors{} {
+	m_cursors.write.store(0, std::memory_order_relaxed);
+	m_cursors.last.store(0, std::memory_order_relaxed);
+	m_cursors.read.store(0, std::memory_order_relaxed);
+	m_cursors.cached_read = 0;
+	m_cursors.cached_write = 0;
+}
+
+template <typename T, bool Padded, bool SeqCst, bool Cached>
+std::size_t Variant<T, Padded, SeqCst, Cached>::put(const T* data, std::size_t size) noexcept {
+	std::size_t f = 0;
+	const auto out = reserve(f);
+	const auto n = std::min(size, f);
+	if (n == 0) {
+		return 0;
+	}
+	memcpy(out, data, n * sizeof(T));
+	m_cursors.write.store(static_cast<std::size_t>(out - m_buf) + n, store_order);
+	return n;
+}
+
+template <typename T, bool Padded, bool SeqCst, bool Cached>
+std::size_t Variant<T, Padded, SeqCst, Cached>::get(T* data, std::size_t size) noexcept {
+	std::size_t a = 0;
+	const auto in = peek(a);
+	const auto n = std::min(size, a);
+	if (n == 0) {
+		return 0;
+	}
+	memcpy(data, in, n * sizeof(T));
+	auto r = static_cast<std::size_t>(in - m_buf) + n;
+	const auto w = Cached ? m_cursors.cached_write : m_cursors.write.load(load_order);
+	if (r > w && r == m_cursors.last.load(std::memory_order_relaxed)) {
+		r = 0;
+	}
+	m_cursors.read.store(r, store_order);
+	return n;
+}
+
+template <typename T, bool Padded, bool SeqCst, bool Cached>
+std::size_t Variant<T, Padded, SeqCst, Cached>::free(std::size_t w, std::size_t r) const noexcept {
+	if (w < r) {
+		return r - w - 1;
+	}
+	return w == m_size ? (r > 0 ? r - 1 : 0) : m_size - w;
+}
+
+template <typename T, bool Padded, bool SeqCst, bool Cached>
+T* Variant<T, Padded, SeqCst, Cached>::reserve(std::size_t& size) noexcept {
+	auto w = m_cursors.write.load(std::memory_order_relaxed);
+	auto r = Cached ? m_cursors.cached_read : m_cursors.read.load(load_order);
+	if (Cached && free(w, r) == 0) {
+		// Only look at the consumer's line when the copy says there is no room.
+		r = m_cursors.cached_read = m_cursors.read.load(load_order);
+	}
+	if (w < r) {
+		size = r - w - 1;
+		return m_buf + w;
+	}
+	if (w == m_size && r > 0) {
+		m_cursors.last.store(w, std::memory_order_relaxed);
+		w = 0;
+		m_cursors.write.store(w, store_order);
+		size = r - 1;
+		return m_buf;
+	}
+	size = m_size - w;
+	return m_buf + w;
+}
+
+template <typename T, bool Padded, bool SeqCst, bool Cached>
+const T* Variant<T, Padded, SeqCst, Cached>::peek(std::size_t& size) noexcept {
+	auto r = m_cursors.read.load(std::memory_order_relaxed);
+	auto w = Cached ? m_cursors.cached_write : m_cursors.write.load(load_order);
+	if (Cached && w == r) {
+		// Only look at the producer's line when the copy says there is no data.
+		w = m_cursors.cached_write = m_cursors.write.load(load_order);
+	}
+	if (w >= r) {
+		size = w - r;
+		return m_buf + r;
+	}
+	const auto l = m_cursors.last.load(std::memory_order_relaxed);
+	if (r == l) {
+		r = 0;
+		m_cursors.read.store(r, store_order);
+		size = w;
+		return m_buf;
+	}
+	size = l - r;
+	return m_buf + r;
+}
+
+} // namespace bench
+
+#endif // BIP_BENCH_VARIANTS_H_INCLUDED
@@ -0,0 +1,143 @@
+/*
+ * Benchmark workloads modeled on production traffic shapes.
+ */
+
+#ifndef BIP_BENCH_WORKLOAD_H_INCLUDED
+#define BIP_BENCH_WORKLOAD_H_INCLUDED
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+#include "Bench.h"
+#include "BipRelax.h"
+
+namespace bench {
+
+enum class Shape {
+    Uniform,
+    Bimodal,
+    Pareto,
+};
+
+/*
+ * Message sizes, in elements, and pacing of a producer/consumer pair
+ */
+struct Workload {
+    const char* name;
+    Shape shape;
+    // Uniform: [min, max]. Bimodal: min or max, max with probability 'large'. Pareto: scale min, shape 'alpha', capped at max.
+    std::size_t min;
+    std::size_t max;
+    double large;
+    double alpha;
+    // The producer sends 'burst' messages back to back then idles for 'gap'. No gaps if 'burst' is 0.
+    std::size_t burst;
+    std::chrono::microseconds gap;
+    // The consumer works this long on each message it reads.
+    std::chrono::nanoseconds cost;
+};
+
+/*
+ * The workload suite
+ */
+inline const Workload* workloads(std::size_t& count) {
+	using std::chrono::microseconds;
+	using std::chrono::nanoseconds;
+	static const Workload suite[] = {
+		{"uniform", Shape::Uniform, 10, 500, 0, 0, 0, microseconds{0}, nanoseconds{0}},
+		{"bimodal", Shape::Bimodal, 16, 1024, 0.1, 0, 0, microseconds{0}, nanoseconds{0}},
+		{"pareto", Shape::Pareto, 8, 4096, 0, 1.2, 0, microseconds{0}, nanoseconds{0}},
+		{"bursty", Shape::Uniform, 32, 128, 0, 0, 256, microseconds{200}, nanoseconds{0}},
+		{"slow-consumer", Shape::Uniform, 10, 500, 0, 0, 0, microseconds{0}, nanoseconds{2000}},
+	};
+	count = sizeof(suite) / sizeof(suite[0]);
+	return suite;
+}
+
+/*
+ * Per-thread source of message sizes and pauses. Each thread seeds its own, from the run seed and its role,
+ * so that runs are reproducible and threads never share generator state
+ */
+class Generator {
+public:
+    Generator(const Workload& workload, std::uint64_t seed, std::uint64_t pair, std::uint64_t role);
+
+    /*
+     * Returns the next message size
+     */
+    std::size_t size();
+
+    /*
+     * Producer: called before each message, idles through the gaps between bursts
+     */
+    inline void pace();
+
+    /*
+     * Consumer: called for each message read, works for the consumer cost
+     */
+    inline void work() const;
+
+private:
+    const Workload& m_workload;
+    std::mt19937_64 m_engine;
+    std::size_t m_sent;
+}; // class Generator
+
+/*
+ * Busy wait for 'duration' on the clock, keeping the core like a real pipeline stage would. Never yields, so the delay
+ * overshoots only by a clock read and a pause instruction
+ */
+inline void spin(clock::duration duration) {
+	const auto until = clock::now() + duration;
+	while (clock::now() < until) {
+		bip::relax();
+	}
+}
+
+} // namespace bench
+
+namespace bench {
+
+inline Generator::Generator(const Workload& workload, std::uint64_t seed, std::uint64_t pair, std::uint64_t role) :
+		m_workload(workload),
+		m_engine{},
+		m_sent{0} {
+	std::seed_seq sequence{seed, pair, role};
+	m_engine.seed(sequence);
+}
+
+inline std::size_t Generator::size() {
+	switch (m_workload.shape) {
+	case Shape::Uniform:
+		return std::uniform_int_distribution<std::size_t>{m_workload.min, m_workload.max}(m_engine);
+	case Shape::Bimodal:
+		return std::bernoulli_distribution{m_workload.large}(m_engine) ? m_workload.max : m_workload.min;
+	case Shape::Pareto: {
+		// Inverse transform of a uniform variate in (0, 1].
+		const auto u = 1 - std::uniform_real_distribution<double>{0, 1}(m_engine);
+		const auto size = static_cast<double>(m_workload.min) / std::pow(u, 1 / m_workload.alpha);
+		return static_cast<std::size_t>(std::min(size, static_cast<double>(m_workload.max)));
+	}
+	}
+	return m_workload.min;
+}
+
+void Generator::pace() {
+	if (m_workload.burst != 0 && m_sent++ == m_workload.burst) {
+		spin(m_workload.gap);
+		m_sent = 1;
+	}
+}
+
+void Generator::work() const {
+	if (m_workload.cost.count() != 0) {
+		spin(m_workload.cost);
+	}
+}
+
+} // namespace bench
+
+#endif // BIP_BENCH_WORKLOAD_H_INCLUDED
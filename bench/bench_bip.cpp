@@ -0,0 +1,582 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "Counters.h"
+#include "Variants.h"
+#include "Workload.h"
+#include "BipBlocking.h"
+#include "BipLz.h"
+#include "BipSpsc.h"
+
+namespace {
+
+using elem_type = std::uint64_t;
+
+constexpr std::size_t ring_size = 4096;
+constexpr std::size_t chunk_size = 64;
+constexpr std::uint64_t default_seed = 1;
+
+// Fixed size messages for placement comparisons.
+const bench::Workload fixed{"fixed", bench::Shape::Uniform, chunk_size, chunk_size, 0, 0, 0,
+		std::chrono::microseconds{0}, std::chrono::nanoseconds{0}};
+
+struct Pair {
+    Pair(const bench::Workload& workload, std::size_t elements, std::uint64_t seed, std::size_t index) :
+		buffer{new elem_type[ring_size]},
+		spsc{buffer.get(), ring_size},
+		workload(workload),
+		elements{elements},
+		seed{seed},
+		index{index},
+		messages{0},
+		elapsed{},
+		valid{true} {}
+
+    std::unique_ptr<elem_type[]> buffer;
+    bip::SPSC<elem_type> spsc;
+    const bench::Workload& workload;
+    const std::size_t elements;
+    const std::uint64_t seed;
+    const std::size_t index;
+    std::size_t messages;
+    bench::clock::duration elapsed;
+    bool valid;
+};
+
+void produce(Pair& pair, int cpu, bench::StartLine& start) {
+	bench::pin(cpu);
+	// First touch from the producer's node.
+	memset(pair.buffer.get(), 0, ring_size * sizeof(elem_type));
+	bench::Generator generator{pair.workload, pair.seed, pair.index, 0};
+	std::vector<elem_type> message(pair.workload.max);
+	start.arrive();
+	for (std::size_t next = 0; next < pair.elements;) {
+		generator.pace();
+		const auto count = std::min(std::max<std::size_t>(generator.size(), 1), pair.elements - next);
+		for (std::size_t i = 0; i < count; ++i) {
+			message[i] = next + i;
+		}
+		std::size_t written = 0;
+		while (written < count) {
+			const auto w = pair.spsc.put(message.data() + written, count - written);
+			if (w == 0) {
+				std::this_thread::yield();
+			}
+			written += w;
+		}
+		next += count;
+		++pair.messages;
+	}
+}
+
+void consume(Pair& pair, int cpu, bench::StartLine& start) {
+	bench::pin(cpu);
+	bench::Generator generator{pair.workload, pair.seed, pair.index, 1};
+	std::vector<elem_type> message(pair.workload.max);
+	start.arrive();
+	const auto begin = bench::clock::now();
+	for (std::size_t expect = 0; expect < pair.elements;) {
+		const auto read = pair.spsc.get(message.data(), std::max<std::size_t>(generator.size(), 1));
+		if (read == 0) {
+			std::this_thread::yield();
+			continue;
+		}
+		generator.work();
+		pair.valid = pair.valid && message[0] == expect && message[read - 1] == expect + read - 1;
+		expect += read;
+	}
+	pair.elapsed = bench::clock::now() - begin;
+}
+
+/*
+ * Run one pair per entry of 'cpus' at the same time. Returns false if any pair lost data
+ */
+bool run(const bench::Workload& workload, const std::vector<std::pair<int, int>>& cpus, std::size_t elements,
+		std::uint64_t seed, std::vector<bench::aligned_ptr<Pair>>& pairs) {
+	pairs.clear();
+	for (std::size_t i = 0; i < cpus.size(); ++i) {
+		pairs.push_back(bench::make_aligned<Pair>(workload, elements, seed, i));
+	}
+	bench::StartLine start{cpus.size() * 2};
+	std::vector<std::thread> threads;
+	for (std::size_t i = 0; i < cpus.size(); ++i) {
+		threads.emplace_back(produce, std::ref(*pairs[i]), cpus[i].first, std::ref(start));
+		threads.emplace_back(consume, std::ref(*pairs[i]), cpus[i].second, std::ref(start));
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	return std::all_of(pairs.begin(), pairs.end(), [](const bench::aligned_ptr<Pair>& pair) { return pair->valid; });
+}
+
+const bench::Counter counters[] = {bench::Counter::Cycles, bench::Counter::Instructions, bench::Counter::L1Misses,
+		bench::Counter::LlcMisses, bench::Counter::Hitm};
+
+void print_counter_header() {
+	for (const auto counter : counters) {
+		std::cout << std::setw(11) << bench::name(counter);
+	}
+	std::cout << std::endl;
+}
+
+/*
+ * Print each counter per operation, an operation being one message moved through a ring
+ */
+void print_counters(const bench::Counters& values, std::size_t operations) {
+	for (const auto counter : counters) {
+		if (values.available(counter)) {
+			std::cout << std::fixed << std::setprecision(1) << std::setw(11) << values.value(counter) / operations;
+		} else {
+			std::cout << std::setw(11) << "-";
+		}
+	}
+	std::cout << std::endl;
+}
+
+/*
+ * Throughput of 1..'max_pairs' independent pairs for each placement
+ */
+int scaling(std::size_t max_pairs, std::size_t megabytes) {
+	const auto cpus = bench::topology();
+	const auto elements = megabytes * 1024 * 1024 / sizeof(elem_type);
+	std::cout << "CPUs: " << cpus.size() << ", " << megabytes << " MiB per pair" << std::endl;
+	{
+		const bench::Counters probe;
+		if (!probe.error().empty()) {
+			std::cout << "Some performance counters are unavailable: " << probe.error() << std::endl;
+		}
+	}
+	std::cout << "Counters are per " << chunk_size * sizeof(elem_type) << " byte chunk" << std::endl;
+	std::cout << std::left << std::setw(14) << "placement" << std::right << std::setw(6) << "pairs"
+			<< std::setw(16) << "total MiB/s" << std::setw(14) << "min MiB/s" << std::setw(14) << "avg MiB/s"
+			<< std::setw(14) << "max MiB/s";
+	print_counter_header();
+	for (const auto placement : {bench::Placement::Unpinned, bench::Placement::Siblings, bench::Placement::Socket,
+			bench::Placement::CrossSocket}) {
+		for (std::size_t count = 1; count <= max_pairs; ++count) {
+			std::vector<std::pair<int, int>> placed;
+			std::cout << std::left << std::setw(14) << bench::name(placement) << std::right << std::setw(6) << count;
+			if (!bench::place(cpus, placement, count, placed)) {
+				std::cout << std::setw(16) << "unavailable" << std::endl;
+				break;
+			}
+			std::vector<bench::aligned_ptr<Pair>> pairs;
+			bench::Counters values;
+			values.start();
+			const auto valid = run(fixed, placed, elements, default_seed, pairs);
+			values.stop();
+			if (!valid) {
+				std::cout << std::endl;
+				std::cerr << "Data mismatch." << std::endl;
+				return 1;
+			}
+			const auto bytes = static_cast<double>(elements * sizeof(elem_type)) / (1024 * 1024);
+			double slowest = 0;
+			double min = 0;
+			double max = 0;
+			double sum = 0;
+			for (const auto& pair : pairs) {
+				const auto seconds = bench::seconds(pair->elapsed);
+				const auto rate = bytes / seconds;
+				slowest = std::max(slowest, seconds);
+				min = sum == 0 ? rate : std::min(min, rate);
+				max = std::max(max, rate);
+				sum += rate;
+			}
+			std::cout << std::fixed << std::setprecision(0) << std::setw(16) << bytes * count / slowest
+					<< std::setw(14) << min << std::setw(14) << sum / count << std::setw(14) << max;
+			print_counters(values, count * ((elements + chunk_size - 1) / chunk_size));
+		}
+	}
+	return 0;
+}
+
+/*
+ * Throughput of one pair for each workload of the suite
+ */
+int workloads(std::size_t megabytes, std::uint64_t seed) {
+	const auto cpus = bench::topology();
+	const auto elements = megabytes * 1024 * 1024 / sizeof(elem_type);
+	// Prefer two cores of one socket, the common pipeline layout.
+	std::vector<std::pair<int, int>> placed;
+	const auto placement = bench::place(cpus, bench::Placement::Socket, 1, placed) ? bench::Placement::Socket
+			: bench::Placement::Unpinned;
+	bench::place(cpus, placement, 1, placed);
+	std::cout << "CPUs: " << cpus.size() << ", " << megabytes << " MiB, " << bench::name(placement) << ", seed " << seed
+			<< std::endl;
+	std::cout << "Counters are per message" << std::endl;
+	std::cout << std::left << std::setw(14) << "workload" << std::right << std::setw(12) << "MiB/s"
+			<< std::setw(14) << "messages/s" << std::setw(12) << "mean size";
+	print_counter_header();
+	std::size_t count = 0;
+	const auto suite = bench::workloads(count);
+	for (std::size_t i = 0; i < count; ++i) {
+		std::vector<bench::aligned_ptr<Pair>> pairs;
+		bench::Counters values;
+		values.start();
+		const auto valid = run(suite[i], placed, elements, seed, pairs);
+		values.stop();
+		if (!valid) {
+			std::cerr << "Data mismatch." << std::endl;
+			return 1;
+		}
+		const auto& pair = *pairs.front();
+		const auto seconds = bench::seconds(pair.elapsed);
+		std::cout << std::left << std::setw(14) << suite[i].name << std::right << std::fixed << std::setprecision(0)
+				<< std::setw(12) << elements * sizeof(elem_type) / (1024 * 1024) / seconds
+				<< std::setw(14) << pair.messages / seconds << std::setprecision(1)
+				<< std::setw(12) << static_cast<double>(elements) / pair.messages;
+		print_counters(values, pair.messages);
+	}
+	return 0;
+}
+
+/*
+ * Move 'elements' through ring 'R' in fixed size chunks, waiting with 'wait' whenever it is full or empty
+ */
+template <typename R>
+bool run_variant(bench::Wait wait, std::pair<int, int> cpus, std::size_t elements, bench::clock::duration& elapsed) {
+	std::unique_ptr<elem_type[]> buffer{new elem_type[ring_size]};
+	auto ring = bench::make_aligned<R>(buffer.get(), ring_size);
+	bench::StartLine start{2};
+	bool valid = true;
+	std::thread producer([&]() {
+		bench::pin(cpus.first);
+		memset(buffer.get(), 0, ring_size * sizeof(elem_type));
+		elem_type chunk[chunk_size];
+		start.arrive();
+		for (std::size_t next = 0; next < elements;) {
+			const auto count = std::min(chunk_size, elements - next);
+			for (std::size_t i = 0; i < count; ++i) {
+				chunk[i] = next + i;
+			}
+			for (std::size_t written = 0; written < count;) {
+				const auto w = ring->put(chunk + written, count - written);
+				if (w == 0) {
+					bench::wait(wait);
+				}
+				written += w;
+			}
+			next += count;
+		}
+	});
+	std::thread consumer([&]() {
+		bench::pin(cpus.second);
+		elem_type chunk[chunk_size];
+		start.arrive();
+		const auto begin = bench::clock::now();
+		for (std::size_t expect = 0; expect < elements;) {
+			const auto read = ring->get(chunk, chunk_size);
+			if (read == 0) {
+				bench::wait(wait);
+				continue;
+			}
+			valid = valid && chunk[0] == expect && chunk[read - 1] == expect + read - 1;
+			expect += read;
+		}
+		elapsed = bench::clock::now() - begin;
+	});
+	producer.join();
+	consumer.join();
+	return valid;
+}
+
+struct Micro {
+    const char* group;
+    const char* name;
+    bench::Wait wait;
+    bool (*run)(bench::Wait, std::pair<int, int>, std::size_t, bench::clock::duration&);
+};
+
+/*
+ * One design choice at a time, each against the padded, acquire/release, uncached, yielding baseline
+ */
+int micro(std::size_t megabytes) {
+	using Baseline = bench::Variant<elem_type, true, false, false>;
+	using Packed = bench::Variant<elem_type, false, false, false>;
+	using SeqCst = bench::Variant<elem_type, true, true, false>;
+	using Cached = bench::Variant<elem_type, true, false, true>;
+	const Micro suite[] = {
+		{"reference", "bip::SPSC", bench::Wait::Yield, run_variant<bip::SPSC<elem_type>>},
+		{"layout", "padded", bench::Wait::Yield, run_variant<Baseline>},
+		{"layout", "packed", bench::Wait::Yield, run_variant<Packed>},
+		{"ordering", "acq/rel", bench::Wait::Yield, run_variant<Baseline>},
+		{"ordering", "seq_cst", bench::Wait::Yield, run_variant<SeqCst>},
+		{"cursor", "uncached", bench::Wait::Yield, run_variant<Baseline>},
+		{"cursor", "cached", bench::Wait::Yield, run_variant<Cached>},
+		{"wait", "yield", bench::Wait::Yield, run_variant<Baseline>},
+		{"wait", "spin", bench::Wait::Spin, run_variant<Baseline>},
+		{"wait", "pause", bench::Wait::Pause, run_variant<Baseline>},
+	};
+	const auto cpus = bench::topology();
+	const auto elements = megabytes * 1024 * 1024 / sizeof(elem_type);
+	std::vector<std::pair<int, int>> placed;
+	const auto placement = bench::place(cpus, bench::Placement::Socket, 1, placed) ? bench::Placement::Socket
+			: bench::Placement::Unpinned;
+	bench::place(cpus, placement, 1, placed);
+	std::cout << "CPUs: " << cpus.size() << ", " << megabytes << " MiB, " << bench::name(placement) << std::endl;
+	if (cpus.size() < 2) {
+		std::cout << "Spinning waits burn whole time slices on a single CPU" << std::endl;
+	}
+	std::cout << "Counters are per " << chunk_size * sizeof(elem_type) << " byte chunk" << std::endl;
+	std::cout << std::left << std::setw(11) << "choice" << std::setw(11) << "variant" << std::right
+			<< std::setw(12) << "MiB/s";
+	print_counter_header();
+	for (const auto& variant : suite) {
+		bench::clock::duration elapsed{};
+		bench::Counters values;
+		values.start();
+		const auto valid = variant.run(variant.wait, placed.front(), elements, elapsed);
+		values.stop();
+		if (!valid) {
+			std::cerr << "Data mismatch." << std::endl;
+			return 1;
+		}
+		std::cout << std::left << std::setw(11) << variant.group << std::setw(11) << variant.name << std::right
+				<< std::fixed << std::setprecision(0) << std::setw(12)
+				<< elements * sizeof(elem_type) / (1024 * 1024) / bench::seconds(elapsed);
+		print_counters(values, (elements + chunk_size - 1) / chunk_size);
+	}
+	return 0;
+}
+
+/*
+ * Returns the 'percent' percentile of 'samples', sorting them
+ */
+double percentile(std::vector<std::uint64_t>& samples, double percent) {
+	if (samples.empty()) {
+		return 0;
+	}
+	std::sort(samples.begin(), samples.end());
+	const auto index = static_cast<std::size_t>(percent / 100 * static_cast<double>(samples.size() - 1));
+	return static_cast<double>(samples[index]);
+}
+
+std::uint64_t nanoseconds() {
+	return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			bench::clock::now().time_since_epoch()).count());
+}
+
+/*
+ * Move 'elements' through a blocking ring with batch size 'batch', the producer writing whole rings at a time and the
+ * consumer draining greedily. Elements are timestamps, so that the consumer measures how long each run waited
+ */
+bool run_batched(std::size_t batch, std::pair<int, int> cpus, std::size_t elements, bench::clock::duration& elapsed,
+		std::vector<std::uint64_t>& delivery, std::vector<std::uint64_t>& stalls) {
+	std::unique_ptr<elem_type[]> buffer{new elem_type[ring_size]};
+	bip::BIP<elem_type> bip{buffer.get(), ring_size};
+	bip::Blocking<elem_type> blocking{bip, 64, batch};
+	bench::StartLine start{2};
+	bool valid = true;
+	std::thread producer([&]() {
+		bench::pin(cpus.first);
+		std::vector<elem_type> message(ring_size);
+		start.arrive();
+		for (std::size_t next = 0; next < elements;) {
+			const auto count = std::min(message.size(), elements - next);
+			const auto now = nanoseconds();
+			std::fill(message.begin(), message.begin() + count, now);
+			blocking.put(message.data(), count);
+			stalls.push_back(nanoseconds() - now);
+			next += count;
+		}
+		blocking.close();
+	});
+	std::thread consumer([&]() {
+		bench::pin(cpus.second);
+		start.arrive();
+		const auto begin = bench::clock::now();
+		elem_type last = 0;
+		elem_type sum = 0;
+		while (blocking.drain([&](const elem_type* data, std::size_t size) {
+			delivery.push_back(nanoseconds() - data[0]);
+			valid = valid && data[0] >= last && data[size - 1] >= data[0];
+			last = data[size - 1];
+			// Per element work, so that long runs keep the space from the producer for a while.
+			for (std::size_t i = 0; i < size; ++i) {
+				sum = (sum ^ data[i]) * 0x9e3779b97f4a7c15ull;
+			}
+		})) {
+		}
+		elapsed = bench::clock::now() - begin;
+		valid = valid && sum != 1;
+	});
+	producer.join();
+	consumer.join();
+	return valid;
+}
+
+/*
+ * Throughput against latency of the blocking wrapper for a range of batch sizes
+ */
+int batches(std::size_t megabytes) {
+	const auto cpus = bench::topology();
+	const auto elements = megabytes * 1024 * 1024 / sizeof(elem_type);
+	std::vector<std::pair<int, int>> placed;
+	const auto placement = bench::place(cpus, bench::Placement::Socket, 1, placed) ? bench::Placement::Socket
+			: bench::Placement::Unpinned;
+	bench::place(cpus, placement, 1, placed);
+	std::cout << "CPUs: " << cpus.size() << ", " << megabytes << " MiB, " << bench::name(placement) << ", "
+			<< ring_size * sizeof(elem_type) << " byte ring" << std::endl;
+	std::cout << "Delivery is from put to the consumer's callback, stall is the duration of one producer put, in us"
+			<< std::endl;
+	std::cout << std::setw(8) << "batch" << std::setw(12) << "MiB/s" << std::setw(14) << "delivery p50"
+			<< std::setw(14) << "delivery p99" << std::setw(14) << "delivery max" << std::setw(12) << "stall p99"
+			<< std::setw(12) << "stall max" << std::endl;
+	for (const std::size_t batch : {0, 16, 64, 256, 1024}) {
+		bench::clock::duration elapsed{};
+		std::vector<std::uint64_t> delivery;
+		std::vector<std::uint64_t> stalls;
+		if (!run_batched(batch, placed.front(), elements, elapsed, delivery, stalls)) {
+			std::cerr << "Data mismatch." << std::endl;
+			return 1;
+		}
+		std::cout << std::setw(8) << (batch ? std::to_string(batch) : "none") << std::fixed << std::setprecision(0)
+				<< std::setw(12) << elements * sizeof(elem_type) / (1024 * 1024) / bench::seconds(elapsed)
+				<< std::setprecision(1) << std::setw(14) << percentile(delivery, 50) / 1000
+				<< std::setw(14) << percentile(delivery, 99) / 1000 << std::setw(14) << percentile(delivery, 100) / 1000
+				<< std::setw(12) << percentile(stalls, 99) / 1000 << std::setw(12) << percentile(stalls, 100) / 1000
+				<< std::endl;
+	}
+	return 0;
+}
+
+/*
+ * Returns 'size' bytes of input of kind 'kind': "random" bytes, "logs" lines or "zeros"
+ */
+std::vector<char> corpus(const std::string& kind, std::size_t size) {
+	std::vector<char> data;
+	data.reserve(size);
+	std::mt19937_64 engine{default_seed};
+	if (kind == "random") {
+		while (data.size() < size) {
+			data.push_back(static_cast<char>(engine()));
+		}
+	} else if (kind == "logs") {
+		const char* const levels[] = {"INFO", "WARN", "DEBUG"};
+		while (data.size() < size) {
+			const auto line = std::string{"2026-10-18T12:00:00 "} + levels[engine() % 3] + " request id=" +
+					std::to_string(engine() % 100000) + " latency_us=" + std::to_string(engine() % 5000) + " status=200\n";
+			data.insert(data.end(), line.begin(), line.end());
+		}
+	}
+	data.resize(size);
+	return data;
+}
+
+/*
+ * Stream 'data' through LzCompressor and LzDecompressor between BIP buffers. Returns false on a mismatch or a stall
+ */
+bool run_lz(const std::vector<char>& data, bench::clock::duration& compress, bench::clock::duration& decompress,
+		std::size_t& compressed) {
+	constexpr std::size_t ring = 1024 * 1024;
+	std::unique_ptr<char[]> in_buf{new char[ring]};
+	std::unique_ptr<char[]> out_buf{new char[ring]};
+	bip::BIP<char> in{in_buf.get(), ring};
+	bip::BIP<char> out{out_buf.get(), ring};
+	bip::LzCompressor compressor;
+	bip::LzDecompressor decompressor;
+	std::vector<char> frames(data.size() + data.size() / 8 + 1024);
+	std::vector<char> result(data.size());
+
+	auto begin = bench::clock::now();
+	std::size_t written = 0;
+	compressed = 0;
+	while (written < data.size() || !compressor.idle() || in.have() || out.have()) {
+		const auto put = in.put(data.data() + written, data.size() - written);
+		written += put;
+		const auto consumed = compressor.compress(in, out, written == data.size());
+		const auto read = out.get(frames.data() + compressed, frames.size() - compressed);
+		compressed += read;
+		if (put + consumed + read == 0 && compressor.idle()) {
+			return false;
+		}
+	}
+	compress = bench::clock::now() - begin;
+
+	begin = bench::clock::now();
+	std::size_t fed = 0;
+	std::size_t produced = 0;
+	while (produced < data.size()) {
+		const auto put = in.put(frames.data() + fed, compressed - fed);
+		fed += put;
+		const auto made = decompressor.decompress(in, out);
+		const auto read = out.get(result.data() + produced, result.size() - produced);
+		produced += read;
+		if (decompressor.failed() || put + made + read == 0) {
+			return false;
+		}
+	}
+	decompress = bench::clock::now() - begin;
+	return result == data;
+}
+
+/*
+ * Compression and decompression throughput and ratio on inputs of different compressibility
+ */
+int lz(std::size_t megabytes) {
+	std::cout << megabytes << " MiB per input, " << bip::LzCompressor::max_block << " byte blocks" << std::endl;
+	std::cout << std::left << std::setw(8) << "input" << std::right << std::setw(16) << "compress MiB/s"
+			<< std::setw(18) << "decompress MiB/s" << std::setw(8) << "ratio" << std::endl;
+	for (const auto kind : {"random", "logs", "zeros"}) {
+		const auto data = corpus(kind, megabytes * 1024 * 1024);
+		bench::clock::duration compress{};
+		bench::clock::duration decompress{};
+		std::size_t compressed = 0;
+		if (!run_lz(data, compress, decompress, compressed)) {
+			std::cerr << "Data mismatch." << std::endl;
+			return 1;
+		}
+		std::cout << std::left << std::setw(8) << kind << std::right << std::fixed << std::setprecision(0)
+				<< std::setw(16) << megabytes / bench::seconds(compress) << std::setw(18)
+				<< megabytes / bench::seconds(decompress) << std::setprecision(2) << std::setw(8)
+				<< static_cast<double>(data.size()) / compressed << std::endl;
+	}
+	return 0;
+}
+
+void usage() {
+	std::cerr << "Usage: bip_bench scaling [max pairs] [MiB per pair]" << std::endl;
+	std::cerr << "       bip_bench workloads [MiB] [seed]" << std::endl;
+	std::cerr << "       bip_bench micro [MiB]" << std::endl;
+	std::cerr << "       bip_bench batches [MiB]" << std::endl;
+	std::cerr << "       bip_bench lz [MiB]" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	const std::string mode = argc > 1 ? argv[1] : "scaling";
+	if (mode == "scaling") {
+		const auto cpus = bench::topology().size();
+		const std::size_t max_pairs = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : std::max<std::size_t>(1, cpus / 2);
+		const std::size_t megabytes = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 256;
+		return scaling(max_pairs, megabytes);
+	}
+	if (mode == "workloads") {
+		const std::size_t megabytes = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 256;
+		const std::uint64_t seed = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : default_seed;
+		return workloads(megabytes, seed);
+	}
+	if (mode == "micro") {
+		return micro(argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 256);
+	}
+	if (mode == "lz") {
+		return lz(argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 256);
+	}
+	if (mode == "batches") {
+		return batches(argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 256);
+	}
+	usage();
+	return 1;
+}
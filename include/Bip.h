@@ -8,6 +8,8 @@
 #include <cstdint>
 #include <cstring>
 
+#include "BipProbe.h"
+
 namespace bip {
 
 namespace internal {
@@ -18,6 +20,7 @@ struct Partition {
     inline void put(const T* data, std::size_t size) noexcept;
     inline void get(T* data, std::size_t size) noexcept;
     inline void skip(std::size_t size) noexcept;
+    inline void commit(std::size_t size) noexcept;
     inline std::size_t avail() const noexcept;
     inline std::size_t free() const noexcept;
     inline void reset() noexcept;
@@ -53,6 +56,28 @@ public:
      */
     inline std::size_t skip(std::size_t size) noexcept;
 
+    /*
+     * Returns the contiguous region available for writing and stores its element count in 'size'
+     */
+    inline T* reserve(std::size_t& size) noexcept;
+
+    /*
+     * Mark 'size' elements of the reserved region as written. Returns the count of actual elements committed
+     */
+    inline std::size_t commit(std::size_t size) noexcept;
+
+    /*
+     * Returns the contiguous region available for reading and stores its element count in 'size'.
+     * Consume it with skip()
+     */
+    inline const T* peek(std::size_t& size) const noexcept;
+
+    /*
+     * Store both readable regions in order in 'first' and 'second', with their element counts.
+     * Returns the total count of elements available for reading
+     */
+    inline std::size_t peek(const T*& first, std::size_t& first_size, const T*& second, std::size_t& second_size) const noexcept;
+
     /*
      * Returns how many elements are available for a single read
      */
@@ -63,6 +88,16 @@ public:
      */
     inline std::size_t free() const noexcept;
 
+    /*
+     * Returns how many elements can be written in total, across a partition switch
+     */
+    inline std::size_t space() const noexcept;
+
+    /*
+     * Returns how many elements are available in total, across a partition switch
+     */
+    inline std::size_t size() const noexcept;
+
     /*
      * Returns true if there are no elements available for read
      */
@@ -78,6 +113,11 @@ public:
      */
     inline bool have() const noexcept;
 
+    /*
+     * Returns the element count of the storage
+     */
+    inline std::size_t capacity() const noexcept;
+
 private:
 
     T* const lower;
@@ -86,8 +126,16 @@ private:
     internal::Partition<T> B;
     internal::Partition<T>* Get;
     internal::Partition<T>* Put;
-    internal::Partition<T>* NextGet;
-    internal::Partition<T>* NextPut;
+
+    /*
+     * Move Put to the other partition when the current one can't grow and isn't shared with Get
+     */
+    inline void advance_put() noexcept;
+
+    /*
+     * Retire the exhausted Get partition
+     */
+    inline void advance_get() noexcept;
 }; // class BIP
 
 } // namespace bip
@@ -101,18 +149,19 @@ BIP<T>::BIP(T* buf, std::size_t size) noexcept :
 		A{&lower, &B.begin},
 		B{&A.end, &upper},
 		Get{&B},
-		Put{&B},
-		NextGet{&A},
-		NextPut{&A} {
+		Put{&B} {
 }
 
 template <typename T>
 std::size_t BIP<T>::put(const T* data, std::size_t size) noexcept {
 	const auto f = free();
 	if (size >= f) {
+		// A short put is only full when the other partition can't take the rest either.
+		if (size > f && space() < size) {
+			BIP_PROBE3(full, BIP_PROBE_ID(this), size, space());
+		}
 		Put->put(data, f);
-		NextGet = Put;
-		Put = NextPut;
+		advance_put();
 		return f;
 	}
 	Put->put(data, size);
@@ -123,10 +172,11 @@ template <typename T>
 std::size_t BIP<T>::get(T* data, std::size_t size) noexcept {
 	const auto a = avail();
 	if (size >= a) {
+		if (size > a && this->size() < size) {
+			BIP_PROBE3(empty, BIP_PROBE_ID(this), size, this->size());
+		}
 		Get->get(data, a);
-		Get->reset();
-		NextPut = Get;
-		Get = NextGet;
+		advance_get();
 		return a;
 	}
 	Get->get(data, size);
@@ -138,15 +188,47 @@ std::size_t BIP<T>::skip(std::size_t size) noexcept {
 	const auto a = avail();
 	if (size >= a) {
 		Get->skip(a);
-		Get->reset();
-		NextPut = Get;
-		Get = NextGet;
+		advance_get();
 		return a;
 	}
 	Get->skip(size);
 	return size;
 }
 
+template <typename T>
+T* BIP<T>::reserve(std::size_t& size) noexcept {
+	size = free();
+	BIP_PROBE2(reserve, BIP_PROBE_ID(this), size);
+	return Put->end;
+}
+
+template <typename T>
+std::size_t BIP<T>::commit(std::size_t size) noexcept {
+	const auto f = free();
+	BIP_PROBE3(commit, BIP_PROBE_ID(this), size, f);
+	if (size >= f) {
+		Put->commit(f);
+		advance_put();
+		return f;
+	}
+	Put->commit(size);
+	return size;
+}
+
+template <typename T>
+const T* BIP<T>::peek(std::size_t& size) const noexcept {
+	size = avail();
+	return Get->begin;
+}
+
+template <typename T>
+std::size_t BIP<T>::peek(const T*& first, std::size_t& first_size, const T*& second, std::size_t& second_size) const noexcept {
+	first = peek(first_size);
+	second = Put->begin;
+	second_size = Get != Put ? Put->avail() : 0;
+	return first_size + second_size;
+}
+
 template <typename T>
 std::size_t BIP<T>::avail() const noexcept {
 	return Get->avail();
@@ -157,6 +239,22 @@ std::size_t BIP<T>::free() const noexcept {
 	return Put->free();
 }
 
+template <typename T>
+std::size_t BIP<T>::space() const noexcept {
+	if (Get != Put) {
+		return free();
+	}
+	if (Put == &A) {
+		return upper - A.end;
+	}
+	return free() + (B.begin - lower);
+}
+
+template <typename T>
+std::size_t BIP<T>::size() const noexcept {
+	return Get != Put ? Get->avail() + Put->avail() : avail();
+}
+
 template <typename T>
 bool BIP<T>::empty() const noexcept {
 	return avail() == 0;
@@ -172,6 +270,36 @@ bool BIP<T>::have() const noexcept {
 	return !empty();
 }
 
+template <typename T>
+std::size_t BIP<T>::capacity() const noexcept {
+	return static_cast<std::size_t>(upper - lower);
+}
+
+template <typename T>
+void BIP<T>::advance_put() noexcept {
+	if (Get == Put && Put->free() == 0) {
+		Put = Put == &A ? &B : &A;
+		BIP_PROBE2(put_switch, BIP_PROBE_ID(this), Put == &B);
+	}
+}
+
+template <typename T>
+void BIP<T>::advance_get() noexcept {
+	if (Get != Put) {
+		Get->reset();
+		Get = Put;
+		BIP_PROBE2(get_switch, BIP_PROBE_ID(this), Get == &B);
+		if (Get->avail() != 0) {
+			advance_put();
+			return;
+		}
+	}
+	A.reset();
+	B.reset();
+	Get = Put = &B;
+	BIP_PROBE1(drained, BIP_PROBE_ID(this));
+}
+
 namespace internal {
 
 template <typename T>
@@ -200,6 +328,11 @@ void Partition<T>::skip(std::size_t size) noexcept {
     begin += size;
 }
 
+template <typename T>
+void Partition<T>::commit(std::size_t size) noexcept {
+    end += size;
+}
+
 template <typename T>
 std::size_t Partition<T>::avail() const noexcept {
     return end - begin;
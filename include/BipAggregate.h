@@ -0,0 +1,378 @@
+/*
+ * Windowed aggregation over bi-partitioned circular buffers.
+ */
+
+#ifndef BIP_AGGREGATE_H_INCLUDED
+#define BIP_AGGREGATE_H_INCLUDED
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "Bip.h"
+
+namespace bip {
+
+struct Summary {
+    double sum = 0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+    std::size_t count = 0;
+
+    /*
+     * Returns the arithmetic mean, or 0 if there are no samples
+     */
+    inline double mean() const noexcept;
+
+    /*
+     * Merge the samples of 'other' into this summary
+     */
+    inline Summary& operator+=(const Summary& other) noexcept;
+}; // struct Summary
+
+/*
+ * Summarize 'size' elements at 'data'
+ */
+template <typename T>
+inline Summary summarize(const T* data, std::size_t size) noexcept;
+
+/*
+ * Summarize the last 'last' readable elements of 'bip' in place, or all of them by default
+ */
+template <typename T>
+inline Summary summarize(const BIP<T>& bip, std::size_t last = std::numeric_limits<std::size_t>::max()) noexcept;
+
+/*
+ * Running summary of the last 'length' readable elements of the buffer. Puts add the newest elements, pushing out the
+ * oldest past the length while they are still readable, and reads retire the oldest, each in amortized constant time
+ */
+template <typename T>
+class Window {
+public:
+    /*
+     * Keep a running summary of the last 'length' readable elements of 'bip', or all of them by default.
+     * All puts and reads of 'bip' must go through the window
+     */
+    explicit Window(BIP<T>& bip, std::size_t length = std::numeric_limits<std::size_t>::max());
+
+    /*
+     * Attempt to write 'size' elements from 'data'. Returns the count of actual elements written
+     */
+    std::size_t put(const T* data, std::size_t size) noexcept;
+
+    /*
+     * Attempt to read 'size' elements into 'data'. Returns the count of actual elements read
+     */
+    std::size_t get(T* data, std::size_t size) noexcept;
+
+    /*
+     * Attempt to skip 'size' elements. Returns the count of actual elements skipped
+     */
+    std::size_t skip(std::size_t size) noexcept;
+
+    /*
+     * Returns the summary of the last 'length' readable elements
+     */
+    Summary summary() const noexcept;
+
+private:
+    struct Extreme {
+        std::uint64_t seq;
+        T value;
+    };
+
+    // Monotonic queue of the candidates for the window minimum or maximum.
+    class Extremes {
+    public:
+        explicit Extremes(std::size_t capacity);
+        template <typename Less>
+        void push(std::uint64_t seq, T value, Less less) noexcept;
+        void expire(std::uint64_t seq) noexcept;
+        const T* front() const noexcept;
+    private:
+        std::vector<Extreme> m_ring;
+        std::size_t m_head;
+        std::size_t m_size;
+    };
+
+    void added(const T* data, std::size_t size) noexcept;
+    void removed(const T* data, std::size_t size) noexcept;
+
+    /*
+     * Push the 'size' oldest elements out of the window, reading them from the buffer
+     */
+    void evict(std::size_t size) noexcept;
+
+    BIP<T>& m_bip;
+    const std::size_t m_length;
+    double m_sum;
+    std::uint64_t m_read;  // sequence number of the oldest readable element
+    std::uint64_t m_head;  // of the oldest element in the window
+    std::uint64_t m_tail;  // of the next element put
+    Extremes m_min;
+    Extremes m_max;
+}; // class Window
+
+} // namespace bip
+
+namespace bip {
+
+double Summary::mean() const noexcept {
+	return count ? sum / count : 0;
+}
+
+Summary& Summary::operator+=(const Summary& other) noexcept {
+	sum += other.sum;
+	min = std::min(min, other.min);
+	max = std::max(max, other.max);
+	count += other.count;
+	return *this;
+}
+
+template <typename T>
+Summary summarize(const T* data, std::size_t size) noexcept {
+	// Independent accumulators let the loop vectorize.
+	double sum[4] = {0, 0, 0, 0};
+	double lo[4] = {std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity(),
+			std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity()};
+	double hi[4] = {-lo[0], -lo[0], -lo[0], -lo[0]};
+	std::size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		for (std::size_t j = 0; j < 4; ++j) {
+			const double v = data[i + j];
+			sum[j] += v;
+			lo[j] = v < lo[j] ? v : lo[j];
+			hi[j] = v > hi[j] ? v : hi[j];
+		}
+	}
+	Summary result;
+	for (std::size_t j = 0; j < 4; ++j) {
+		result.sum += sum[j];
+		result.min = std::min(result.min, lo[j]);
+		result.max = std::max(result.max, hi[j]);
+	}
+	for (; i < size; ++i) {
+		const double v = data[i];
+		result.sum += v;
+		result.min = std::min(result.min, v);
+		result.max = std::max(result.max, v);
+	}
+	result.count = size;
+	return result;
+}
+
+#if defined(__SSE2__)
+template <>
+inline Summary summarize<double>(const double* data, std::size_t size) noexcept {
+	auto sum0 = _mm_setzero_pd();
+	auto sum1 = _mm_setzero_pd();
+	auto lo0 = _mm_set1_pd(std::numeric_limits<double>::infinity());
+	auto lo1 = lo0;
+	auto hi0 = _mm_set1_pd(-std::numeric_limits<double>::infinity());
+	auto hi1 = hi0;
+	std::size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		const auto a = _mm_loadu_pd(data + i);
+		const auto b = _mm_loadu_pd(data + i + 2);
+		sum0 = _mm_add_pd(sum0, a);
+		sum1 = _mm_add_pd(sum1, b);
+		lo0 = _mm_min_pd(lo0, a);
+		lo1 = _mm_min_pd(lo1, b);
+		hi0 = _mm_max_pd(hi0, a);
+		hi1 = _mm_max_pd(hi1, b);
+	}
+	double sum[2], lo[2], hi[2];
+	_mm_storeu_pd(sum, _mm_add_pd(sum0, sum1));
+	_mm_storeu_pd(lo, _mm_min_pd(lo0, lo1));
+	_mm_storeu_pd(hi, _mm_max_pd(hi0, hi1));
+	Summary result;
+	result.sum = sum[0] + sum[1];
+	result.min = std::min(lo[0], lo[1]);
+	result.max = std::max(hi[0], hi[1]);
+	for (; i < size; ++i) {
+		result.sum += data[i];
+		result.min = std::min(result.min, data[i]);
+		result.max = std::max(result.max, data[i]);
+	}
+	result.count = size;
+	return result;
+}
+#endif
+
+template <typename T>
+Summary summarize(const BIP<T>& bip, std::size_t last) noexcept {
+	const T* first = nullptr;
+	const T* second = nullptr;
+	std::size_t first_size = 0;
+	std::size_t second_size = 0;
+	const auto total = bip.peek(first, first_size, second, second_size);
+	if (last < total) {
+		// Drop the oldest elements.
+		const auto drop = total - last;
+		const auto from_first = std::min(drop, first_size);
+		first += from_first;
+		first_size -= from_first;
+		second += drop - from_first;
+		second_size -= drop - from_first;
+	}
+	auto result = summarize(first, first_size);
+	result += summarize(second, second_size);
+	return result;
+}
+
+template <typename T>
+Window<T>::Window(BIP<T>& bip, std::size_t length) :
+		m_bip(bip),
+		m_length{std::max<std::size_t>(length, 1)},
+		m_sum{},
+		m_read{},
+		m_head{},
+		m_tail{},
+		// The candidates are distinct elements of the window, which is no longer than the storage.
+		m_min{std::min(m_length, bip.capacity())},
+		m_max{std::min(m_length, bip.capacity())} {
+	const T* first = nullptr;
+	const T* second = nullptr;
+	std::size_t first_size = 0;
+	std::size_t second_size = 0;
+	m_bip.peek(first, first_size, second, second_size);
+	added(first, first_size);
+	added(second, second_size);
+}
+
+template <typename T>
+std::size_t Window<T>::put(const T* data, std::size_t size) noexcept {
+	const auto written = m_bip.put(data, size);
+	added(data, written);
+	return written;
+}
+
+template <typename T>
+std::size_t Window<T>::get(T* data, std::size_t size) noexcept {
+	const auto read = m_bip.get(data, size);
+	removed(data, read);
+	return read;
+}
+
+template <typename T>
+std::size_t Window<T>::skip(std::size_t size) noexcept {
+	std::size_t avail = 0;
+	const auto span = m_bip.peek(avail);
+	const auto skipped = m_bip.skip(size);
+	removed(span, skipped);
+	return skipped;
+}
+
+template <typename T>
+Summary Window<T>::summary() const noexcept {
+	Summary result;
+	result.count = m_tail - m_head;
+	if (result.count) {
+		result.sum = m_sum;
+		result.min = *m_min.front();
+		result.max = *m_max.front();
+	}
+	return result;
+}
+
+template <typename T>
+void Window<T>::added(const T* data, std::size_t size) noexcept {
+	// Make room before pushing, so that the candidates never outnumber the window.
+	const auto window = static_cast<std::size_t>(m_tail - m_head);
+	if (window + size > m_length) {
+		evict(std::min(window, window + size - m_length));
+	}
+	if (size > m_length) {
+		// The first elements are pushed out by the last ones right away.
+		data += size - m_length;
+		m_tail += size - m_length;
+		m_head = m_tail;
+		size = m_length;
+	}
+	for (std::size_t i = 0; i < size; ++i, ++m_tail) {
+		m_sum += data[i];
+		m_min.push(m_tail, data[i], [](const T& l, const T& r) { return l < r; });
+		m_max.push(m_tail, data[i], [](const T& l, const T& r) { return r < l; });
+	}
+}
+
+template <typename T>
+void Window<T>::removed(const T* data, std::size_t size) noexcept {
+	// Elements already pushed out of the window were taken off the sum then.
+	const auto read = m_read;
+	m_read += size;
+	if (m_head >= m_read) {
+		return;
+	}
+	for (auto i = static_cast<std::size_t>(m_head - read); i < size; ++i) {
+		m_sum -= data[i];
+	}
+	m_head = m_read;
+	m_min.expire(m_head);
+	m_max.expire(m_head);
+	if (m_head == m_tail) {
+		// Start over to shed accumulated rounding errors.
+		m_sum = 0;
+	}
+}
+
+template <typename T>
+void Window<T>::evict(std::size_t size) noexcept {
+	const T* region[2] = {};
+	std::size_t region_size[2] = {};
+	m_bip.peek(region[0], region_size[0], region[1], region_size[1]);
+	auto offset = static_cast<std::size_t>(m_head - m_read);
+	for (std::size_t r = 0, left = size; r < 2 && left; ++r) {
+		if (offset >= region_size[r]) {
+			offset -= region_size[r];
+			continue;
+		}
+		const auto n = std::min(left, region_size[r] - offset);
+		for (std::size_t i = 0; i < n; ++i) {
+			m_sum -= region[r][offset + i];
+		}
+		left -= n;
+		offset = 0;
+	}
+	m_head += size;
+	m_min.expire(m_head);
+	m_max.expire(m_head);
+}
+
+template <typename T>
+Window<T>::Extremes::Extremes(std::size_t capacity) :
+		m_ring(std::max<std::size_t>(capacity, 1)),
+		m_head{},
+		m_size{} {
+}
+
+template <typename T>
+template <typename Less>
+void Window<T>::Extremes::push(std::uint64_t seq, T value, Less less) noexcept {
+	while (m_size && !less(m_ring[(m_head + m_size - 1) % m_ring.size()].value, value)) {
+		--m_size;
+	}
+	m_ring[(m_head + m_size++) % m_ring.size()] = Extreme{seq, value};
+}
+
+template <typename T>
+void Window<T>::Extremes::expire(std::uint64_t seq) noexcept {
+	while (m_size && m_ring[m_head].seq < seq) {
+		m_head = (m_head + 1) % m_ring.size();
+		--m_size;
+	}
+}
+
+template <typename T>
+const T* Window<T>::Extremes::front() const noexcept {
+	return m_size ? &m_ring[m_head].value : nullptr;
+}
+
+} // namespace bip
+
+#endif // BIP_AGGREGATE_H_INCLUDED
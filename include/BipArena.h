@@ -0,0 +1,248 @@
+/*
+ * Arena of bi-partitioned circular buffers carved from one allocation.
+ */
+
+#ifndef BIP_ARENA_H_INCLUDED
+#define BIP_ARENA_H_INCLUDED
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include <sys/mman.h>
+
+#include "Bip.h"
+
+namespace bip {
+
+/*
+ * Buffers of a few size classes, each buffer next to its storage in one block. acquire() finds the class of a size by
+ * binary search over the classes, then one with a free buffer from a bit mask, release() and capacity() read the class
+ * from the buffer's slot header. Not thread safe
+ */
+template <typename T>
+class Arena {
+public:
+    struct Class {
+        std::size_t size;   // elements per buffer
+        std::size_t count;  // buffers of this size
+    };
+
+    static constexpr std::size_t cache_line = 64;
+    static constexpr std::size_t huge_page = 2 * 1024 * 1024;
+    static constexpr std::size_t max_classes = 64;
+
+    /*
+     * Allocate one block holding 'count' buffers of 'size' elements for every class in 'classes'.
+     * With 'huge', the block is backed by huge pages where available. Throws std::invalid_argument for more than
+     * 'max_classes' classes, and std::bad_alloc on failure
+     */
+    explicit Arena(std::initializer_list<Class> classes, bool huge = false);
+
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /*
+     * Construct a buffer of the smallest class holding at least 'size' elements. Returns nullptr if none is free
+     */
+    BIP<T>* acquire(std::size_t size) noexcept;
+
+    /*
+     * Return buffer 'bip' obtained from acquire() to the arena. Returns false, changing nothing, if 'bip' isn't a buffer
+     * of this arena currently acquired, including nullptr
+     */
+    bool release(BIP<T>* bip) noexcept;
+
+    /*
+     * Returns the element count of buffer 'bip' storage, or 0 if 'bip' isn't a buffer of this arena
+     */
+    std::size_t capacity(const BIP<T>* bip) const noexcept;
+
+    /*
+     * Returns the total byte count of the underlying allocation
+     */
+    inline std::size_t bytes() const noexcept;
+
+private:
+    struct Region {
+        std::size_t size;
+        std::size_t offset;
+        std::size_t stride;
+        std::size_t count;
+        std::vector<std::size_t> free;
+        std::vector<bool> busy;
+    };
+
+    static constexpr std::size_t align(std::size_t bytes) noexcept {
+        return (bytes + cache_line - 1) / cache_line * cache_line;
+    }
+
+    // The region index of a slot follows its buffer, within the cache line padding.
+    static constexpr std::size_t tag = (sizeof(BIP<T>) + alignof(std::size_t) - 1) / alignof(std::size_t) * alignof(std::size_t);
+    static constexpr std::size_t header = (tag + sizeof(std::size_t) + cache_line - 1) / cache_line * cache_line;
+
+    /*
+     * Returns the region of buffer 'bip' and stores its slot index in 'slot', or returns nullptr if 'bip' isn't the
+     * start of a slot
+     */
+    const Region* region(const BIP<T>* bip, std::size_t& slot) const noexcept;
+
+    std::vector<Region> m_regions;
+    std::uint64_t m_available; // bit i set while region i has a free slot
+    unsigned char* m_base;
+    std::size_t m_bytes;
+}; // class Arena
+
+} // namespace bip
+
+namespace bip {
+
+template <typename T>
+constexpr std::size_t Arena<T>::cache_line;
+
+template <typename T>
+constexpr std::size_t Arena<T>::huge_page;
+
+template <typename T>
+constexpr std::size_t Arena<T>::max_classes;
+
+template <typename T>
+constexpr std::size_t Arena<T>::tag;
+
+template <typename T>
+constexpr std::size_t Arena<T>::header;
+
+template <typename T>
+Arena<T>::Arena(std::initializer_list<Class> classes, bool huge) :
+		m_regions{},
+		m_available{},
+		m_base{},
+		m_bytes{} {
+	static_assert(alignof(T) <= cache_line, "Element alignment exceeds a cache line");
+	static_assert(std::is_trivially_destructible<BIP<T>>::value, "Arena doesn't destroy its buffers");
+	if (classes.size() > max_classes) {
+		throw std::invalid_argument{"Arena size classes"};
+	}
+	for (const auto& c : classes) {
+		m_regions.push_back(Region{c.size, 0, header + align(c.size * sizeof(T)), c.count, {}, std::vector<bool>(c.count)});
+	}
+	std::sort(std::begin(m_regions), std::end(m_regions), [](const Region& l, const Region& r) {
+		return l.size < r.size;
+	});
+	for (auto& r : m_regions) {
+		r.offset = m_bytes;
+		m_bytes += r.stride * r.count;
+		r.free.reserve(r.count);
+		for (std::size_t i = r.count; i-- > 0;) {
+			r.free.push_back(i);
+		}
+		if (r.count) {
+			m_available |= std::uint64_t{1} << (&r - m_regions.data());
+		}
+	}
+	m_bytes = std::max<std::size_t>(m_bytes, 1);
+
+	void* base = MAP_FAILED;
+	if (huge) {
+		m_bytes = (m_bytes + huge_page - 1) / huge_page * huge_page;
+#ifdef MAP_HUGETLB
+		base = mmap(nullptr, m_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+	}
+	if (base == MAP_FAILED) {
+		base = mmap(nullptr, m_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (base == MAP_FAILED) {
+			throw std::bad_alloc{};
+		}
+#ifdef MADV_HUGEPAGE
+		if (huge) {
+			madvise(base, m_bytes, MADV_HUGEPAGE);
+		}
+#endif
+	}
+	m_base = static_cast<unsigned char*>(base);
+}
+
+template <typename T>
+Arena<T>::~Arena() {
+	munmap(m_base, m_bytes);
+}
+
+template <typename T>
+BIP<T>* Arena<T>::acquire(std::size_t size) noexcept {
+	const auto first = std::lower_bound(std::begin(m_regions), std::end(m_regions), size, [](const Region& r, std::size_t s) {
+		return r.size < s;
+	}) - std::begin(m_regions);
+	if (static_cast<std::size_t>(first) == m_regions.size() || (m_available >> first) == 0) {
+		return nullptr;
+	}
+	const auto index = static_cast<std::size_t>(first + __builtin_ctzll(m_available >> first));
+	auto& r = m_regions[index];
+	const auto free = r.free.back();
+	r.free.pop_back();
+	if (r.free.empty()) {
+		m_available &= ~(std::uint64_t{1} << index);
+	}
+	r.busy[free] = true;
+	auto slot = m_base + r.offset + free * r.stride;
+	memcpy(slot + tag, &index, sizeof(index));
+	return new (slot) BIP<T>{reinterpret_cast<T*>(slot + header), r.size};
+}
+
+template <typename T>
+bool Arena<T>::release(BIP<T>* bip) noexcept {
+	std::size_t slot = 0;
+	auto r = const_cast<Region*>(region(bip, slot));
+	if (!r || !r->busy[slot]) {
+		return false;
+	}
+	r->busy[slot] = false;
+	r->free.push_back(slot);
+	m_available |= std::uint64_t{1} << (r - m_regions.data());
+	return true;
+}
+
+template <typename T>
+std::size_t Arena<T>::capacity(const BIP<T>* bip) const noexcept {
+	std::size_t slot = 0;
+	const auto r = region(bip, slot);
+	return r ? r->size : 0;
+}
+
+template <typename T>
+std::size_t Arena<T>::bytes() const noexcept {
+	return m_bytes;
+}
+
+template <typename T>
+auto Arena<T>::region(const BIP<T>* bip, std::size_t& slot) const noexcept -> const Region* {
+	const auto address = reinterpret_cast<std::uintptr_t>(bip);
+	const auto base = reinterpret_cast<std::uintptr_t>(m_base);
+	if (address < base || address - base >= m_bytes || m_bytes - (address - base) < header) {
+		return nullptr;
+	}
+	const auto offset = static_cast<std::size_t>(address - base);
+	// The tag of a foreign pointer is garbage, so it must name a region that has a slot starting there.
+	std::size_t index = 0;
+	memcpy(&index, m_base + offset + tag, sizeof(index));
+	if (index >= m_regions.size()) {
+		return nullptr;
+	}
+	const auto& r = m_regions[index];
+	if (offset < r.offset || (offset - r.offset) % r.stride != 0 || (offset - r.offset) / r.stride >= r.count) {
+		return nullptr;
+	}
+	slot = (offset - r.offset) / r.stride;
+	return &r;
+}
+
+} // namespace bip
+
+#endif // BIP_ARENA_H_INCLUDED
@@ -0,0 +1,259 @@
+/*
+ * Blocking access to a bi-partitioned circular buffer.
+ */
+
+#ifndef BIP_BLOCKING_H_INCLUDED
+#define BIP_BLOCKING_H_INCLUDED
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "Bip.h"
+#include "BipProbe.h"
+#include "BipRelax.h"
+
+namespace bip {
+
+template <typename T>
+class Blocking {
+public:
+    /*
+     * Wrap BIP buffer 'bip' for one producer and one consumer thread. Waits spin 'spin' times on a pause instruction
+     * before sleeping. Each operation moves at most 'batch' elements while holding the lock, or any number if 0
+     */
+    explicit Blocking(BIP<T>& bip, unsigned spin = 64, std::size_t batch = 0) noexcept;
+
+    Blocking(const Blocking&) = delete;
+    Blocking& operator=(const Blocking&) = delete;
+
+    /*
+     * Write 'size' elements from 'data', waiting for free space as needed. With a batch size, yields between batches.
+     * Returns less than 'size' only if closed
+     */
+    std::size_t put(const T* data, std::size_t size);
+
+    /*
+     * Read up to 'size' elements into 'data', waiting until at least one is available. Returns 0 only if closed and drained
+     */
+    std::size_t get(T* data, std::size_t size);
+
+    /*
+     * Attempt to write 'size' elements from 'data' without waiting. Returns the count of actual elements written
+     */
+    std::size_t try_put(const T* data, std::size_t size);
+
+    /*
+     * Attempt to read 'size' elements into 'data' without waiting. Returns the count of actual elements read
+     */
+    std::size_t try_get(T* data, std::size_t size);
+
+    /*
+     * Wait until elements are available, then pass those readable by then to 'f' as f(const T* data, std::size_t size),
+     * in place, in contiguous runs of at most the batch size. 'f' runs without the lock, and each run's space goes
+     * back to the producer once it returns. Returns the count of elements passed, 0 only if closed and drained
+     */
+    template <typename F>
+    std::size_t drain(F f);
+
+    /*
+     * Wake all waiters. Subsequent puts fail, gets drain what is left
+     */
+    void close();
+
+    /*
+     * Returns true if close() was called
+     */
+    bool closed();
+
+    /*
+     * Call 'f' with the wrapped buffer while holding the lock, waking waiters afterwards. Returns the result of 'f'
+     */
+    template <typename F>
+    auto locked(F f) -> decltype(f(std::declval<BIP<T>&>()));
+
+private:
+    template <typename P>
+    void wait(std::unique_lock<std::mutex>& lock, std::condition_variable& condition, unsigned& waiters, P ready);
+
+    void notify(std::size_t written, std::size_t read);
+
+    inline std::size_t bounded(std::size_t size) const noexcept;
+
+    BIP<T>& m_bip;
+    const unsigned m_spin;
+    const std::size_t m_batch;
+    std::mutex m_mutex;
+    std::condition_variable m_not_empty;
+    std::condition_variable m_not_full;
+    unsigned m_empty_waiters;
+    unsigned m_full_waiters;
+    bool m_closed;
+}; // class Blocking
+
+} // namespace bip
+
+namespace bip {
+
+template <typename T>
+Blocking<T>::Blocking(BIP<T>& bip, unsigned spin, std::size_t batch) noexcept :
+		m_bip(bip),
+		m_spin{spin},
+		m_batch{batch},
+		m_mutex{},
+		m_not_empty{},
+		m_not_full{},
+		m_empty_waiters{},
+		m_full_waiters{},
+		m_closed{} {
+}
+
+template <typename T>
+std::size_t Blocking<T>::put(const T* data, std::size_t size) {
+	std::size_t written = 0;
+	auto lock = std::unique_lock<std::mutex>{m_mutex};
+	while (written < size) {
+		wait(lock, m_not_full, m_full_waiters, [this]() {
+			return m_closed || !m_bip.full();
+		});
+		if (m_closed) {
+			break;
+		}
+		const auto w = m_bip.put(data + written, bounded(size - written));
+		written += w;
+		notify(w, 0);
+		// Yield point, so that the consumer takes the batch before the next one.
+		if (m_batch && written < size) {
+			lock.unlock();
+			std::this_thread::yield();
+			lock.lock();
+		}
+	}
+	return written;
+}
+
+template <typename T>
+std::size_t Blocking<T>::get(T* data, std::size_t size) {
+	if (size == 0) {
+		return 0;
+	}
+	auto lock = std::unique_lock<std::mutex>{m_mutex};
+	wait(lock, m_not_empty, m_empty_waiters, [this]() {
+		return m_closed || m_bip.have();
+	});
+	const auto read = m_bip.get(data, bounded(size));
+	notify(0, read);
+	return read;
+}
+
+template <typename T>
+std::size_t Blocking<T>::try_put(const T* data, std::size_t size) {
+	auto lock = std::unique_lock<std::mutex>{m_mutex};
+	if (m_closed) {
+		return 0;
+	}
+	const auto written = m_bip.put(data, bounded(size));
+	notify(written, 0);
+	return written;
+}
+
+template <typename T>
+std::size_t Blocking<T>::try_get(T* data, std::size_t size) {
+	auto lock = std::unique_lock<std::mutex>{m_mutex};
+	const auto read = m_bip.get(data, bounded(size));
+	notify(0, read);
+	return read;
+}
+
+template <typename T>
+template <typename F>
+std::size_t Blocking<T>::drain(F f) {
+	std::size_t drained = 0;
+	auto lock = std::unique_lock<std::mutex>{m_mutex};
+	wait(lock, m_not_empty, m_empty_waiters, [this]() {
+		return m_closed || m_bip.have();
+	});
+	// Only what is readable now, so that a fast producer can't keep the call going.
+	const auto total = m_bip.size();
+	while (drained < total) {
+		std::size_t size = 0;
+		const auto data = m_bip.peek(size);
+		size = bounded(std::min(size, total - drained));
+		// The producer only writes outside the readable regions, so the run stays in place until skipped.
+		lock.unlock();
+		f(data, size);
+		lock.lock();
+		m_bip.skip(size);
+		notify(0, size);
+		drained += size;
+	}
+	return drained;
+}
+
+template <typename T>
+void Blocking<T>::close() {
+	auto lock = std::unique_lock<std::mutex>{m_mutex};
+	m_closed = true;
+	BIP_PROBE1(close, BIP_PROBE_ID(&m_bip));
+	m_not_empty.notify_all();
+	m_not_full.notify_all();
+}
+
+template <typename T>
+bool Blocking<T>::closed() {
+	auto lock = std::unique_lock<std::mutex>{m_mutex};
+	return m_closed;
+}
+
+template <typename T>
+template <typename F>
+auto Blocking<T>::locked(F f) -> decltype(f(std::declval<BIP<T>&>())) {
+	auto lock = std::unique_lock<std::mutex>{m_mutex};
+	struct Notify {
+		Blocking* self;
+		~Notify() { self->notify(1, 1); }
+	} n{this};
+	return f(m_bip);
+}
+
+template <typename T>
+template <typename P>
+void Blocking<T>::wait(std::unique_lock<std::mutex>& lock, std::condition_variable& condition, unsigned& waiters, P ready) {
+	// Spinning on a pause instruction stays in user space, as the shared memory wrapper's does.
+	for (unsigned i = 0; i < m_spin && !ready(); ++i) {
+		lock.unlock();
+		relax();
+		lock.lock();
+	}
+	if (ready()) {
+		return;
+	}
+	// Probe argument 1 is 1 while waiting for space, 0 while waiting for data.
+	BIP_PROBE2(wait_enter, BIP_PROBE_ID(&m_bip), &condition == &m_not_full);
+	++waiters;
+	condition.wait(lock, ready);
+	--waiters;
+	BIP_PROBE2(wait_exit, BIP_PROBE_ID(&m_bip), &condition == &m_not_full);
+}
+
+template <typename T>
+void Blocking<T>::notify(std::size_t written, std::size_t read) {
+	if (written && m_empty_waiters) {
+		m_not_empty.notify_one();
+	}
+	if (read && m_full_waiters) {
+		m_not_full.notify_one();
+	}
+}
+
+template <typename T>
+std::size_t Blocking<T>::bounded(std::size_t size) const noexcept {
+	return m_batch && size > m_batch ? m_batch : size;
+}
+
+} // namespace bip
+
+#endif // BIP_BLOCKING_H_INCLUDED
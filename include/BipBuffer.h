@@ -0,0 +1,349 @@
+/*
+ * Bi-partitioned circular buffers owning their storage, drawn from an allocator.
+ */
+
+#ifndef BIP_BUFFER_H_INCLUDED
+#define BIP_BUFFER_H_INCLUDED
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define BIP_HAVE_PMR 1
+#endif
+#endif
+
+#include "Bip.h"
+
+namespace bip {
+
+namespace internal {
+
+/*
+ * Storage of an owning buffer, a base so that it is allocated before the BIP<T> base is constructed over it
+ */
+template <typename T, typename Allocator>
+struct Storage {
+    using traits = std::allocator_traits<Allocator>;
+
+    Storage(std::size_t size, const Allocator& allocator);
+    ~Storage();
+
+    Storage(const Storage&) = delete;
+    Storage& operator=(const Storage&) = delete;
+
+    Allocator allocator;
+    T* const data;
+    const std::size_t count;
+}; // struct Storage
+
+} // namespace internal
+
+/*
+ * A BIP buffer of 'size' elements whose storage comes from 'Allocator'. Usable wherever a BIP<T> is
+ */
+template <typename T, typename Allocator = std::allocator<T>>
+class Buffer : private internal::Storage<T, Allocator>, public BIP<T> {
+public:
+    using allocator_type = Allocator;
+
+    /*
+     * Allocate 'size' elements from 'allocator'. Throws whatever the allocator throws
+     */
+    explicit Buffer(std::size_t size, const Allocator& allocator = Allocator());
+
+    /*
+     * Returns the allocator the storage came from
+     */
+    inline allocator_type get_allocator() const;
+
+    /*
+     * Returns the total elements count of the storage
+     */
+    inline std::size_t capacity() const noexcept;
+}; // class Buffer
+
+/*
+ * Unbounded FIFO of BIP buffer segments of a fixed size. A full tail segment gets a new one linked after it and
+ * drained head segments go back to the allocator, except for one spare kept against churn. Not thread safe
+ */
+template <typename T, typename Allocator = std::allocator<T>>
+class Chain {
+public:
+    using allocator_type = Allocator;
+
+    /*
+     * Chain segments of 'segment' elements from 'allocator', at most 'limit' of them at a time unless 'limit' is 0.
+     * Throws std::invalid_argument if 'segment' is 0, as no segment could hold anything
+     */
+    explicit Chain(std::size_t segment, std::size_t limit = 0, const Allocator& allocator = Allocator());
+
+    ~Chain();
+
+    Chain(const Chain&) = delete;
+    Chain& operator=(const Chain&) = delete;
+
+    /*
+     * Write 'size' elements from 'data', adding segments as needed. Returns less than 'size' only at the segment limit.
+     * Throws whatever the allocator throws, having written what fitted before
+     */
+    std::size_t put(const T* data, std::size_t size);
+
+    /*
+     * Attempt to read 'size' elements into 'data'. Returns the count of actual elements read
+     */
+    std::size_t get(T* data, std::size_t size) noexcept;
+
+    /*
+     * Attempt to skip 'size' elements. Returns the count of actual elements skipped
+     */
+    std::size_t skip(std::size_t size) noexcept;
+
+    /*
+     * Returns the contiguous region available for reading and stores its element count in 'size'. Consume it with skip()
+     */
+    inline const T* peek(std::size_t& size) const noexcept;
+
+    /*
+     * Returns how many elements are available in total
+     */
+    inline std::size_t size() const noexcept;
+
+    /*
+     * Returns true if there are no elements available for read
+     */
+    inline bool empty() const noexcept;
+
+    /*
+     * Returns the count of segments in use
+     */
+    inline std::size_t segments() const noexcept;
+
+private:
+    struct Segment;
+
+    using segment_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Segment>;
+    using segment_traits = std::allocator_traits<segment_allocator>;
+
+    Segment* acquire();
+    void release(Segment* segment) noexcept;
+    void retire() noexcept;
+
+    segment_allocator m_allocator;
+    const std::size_t m_segment;
+    const std::size_t m_limit;
+    Segment* m_head;
+    Segment* m_tail;
+    Segment* m_spare;
+    std::size_t m_segments;
+    std::size_t m_size;
+}; // class Chain
+
+template <typename T, typename Allocator>
+struct Chain<T, Allocator>::Segment {
+    Segment(std::size_t size, const Allocator& allocator) : next{}, buffer{size, allocator} {}
+
+    Segment(const Segment&) = delete;
+    Segment& operator=(const Segment&) = delete;
+
+    Segment* next;
+    Buffer<T, Allocator> buffer;
+}; // struct Chain<T, Allocator>::Segment
+
+#ifdef BIP_HAVE_PMR
+namespace pmr {
+
+/*
+ * Buffers drawing from a std::pmr::memory_resource, e.g. bip::pmr::Buffer<char> buffer{4096, &pool}
+ */
+template <typename T>
+using Buffer = bip::Buffer<T, std::pmr::polymorphic_allocator<T>>;
+
+template <typename T>
+using Chain = bip::Chain<T, std::pmr::polymorphic_allocator<T>>;
+
+} // namespace pmr
+#endif
+
+} // namespace bip
+
+namespace bip {
+
+namespace internal {
+
+template <typename T, typename Allocator>
+Storage<T, Allocator>::Storage(std::size_t size, const Allocator& allocator) :
+		allocator(allocator),
+		data{traits::allocate(this->allocator, size)},
+		count{size} {
+}
+
+template <typename T, typename Allocator>
+Storage<T, Allocator>::~Storage() {
+	traits::deallocate(allocator, data, count);
+}
+
+} // namespace internal
+
+template <typename T, typename Allocator>
+Buffer<T, Allocator>::Buffer(std::size_t size, const Allocator& allocator) :
+		internal::Storage<T, Allocator>{size, allocator},
+		BIP<T>{this->data, size} {
+	static_assert(std::is_same<T, typename Allocator::value_type>::value, "Allocator must allocate T");
+}
+
+template <typename T, typename Allocator>
+auto Buffer<T, Allocator>::get_allocator() const -> allocator_type {
+	return this->allocator;
+}
+
+template <typename T, typename Allocator>
+std::size_t Buffer<T, Allocator>::capacity() const noexcept {
+	return this->count;
+}
+
+template <typename T, typename Allocator>
+Chain<T, Allocator>::Chain(std::size_t segment, std::size_t limit, const Allocator& allocator) :
+		m_allocator(allocator),
+		m_segment{segment},
+		m_limit{limit},
+		m_head{},
+		m_tail{},
+		m_spare{},
+		m_segments{},
+		m_size{} {
+	if (segment == 0) {
+		throw std::invalid_argument{"Chain segment size"};
+	}
+}
+
+template <typename T, typename Allocator>
+Chain<T, Allocator>::~Chain() {
+	while (m_head) {
+		const auto next = m_head->next;
+		release(m_head);
+		m_head = next;
+	}
+	if (m_spare) {
+		release(m_spare);
+	}
+}
+
+template <typename T, typename Allocator>
+std::size_t Chain<T, Allocator>::put(const T* data, std::size_t size) {
+	std::size_t written = 0;
+	while (written < size) {
+		auto w = m_tail ? m_tail->buffer.put(data + written, size - written) : 0;
+		if (w == 0) {
+			if (m_limit && m_segments == m_limit) {
+				break;
+			}
+			const auto segment = acquire();
+			if (m_tail) {
+				m_tail->next = segment;
+			} else {
+				m_head = segment;
+			}
+			m_tail = segment;
+			++m_segments;
+		}
+		written += w;
+		m_size += w;
+	}
+	return written;
+}
+
+template <typename T, typename Allocator>
+std::size_t Chain<T, Allocator>::get(T* data, std::size_t size) noexcept {
+	std::size_t read = 0;
+	while (read < size && m_size) {
+		const auto r = m_head->buffer.get(data + read, size - read);
+		read += r;
+		m_size -= r;
+		retire();
+	}
+	return read;
+}
+
+template <typename T, typename Allocator>
+std::size_t Chain<T, Allocator>::skip(std::size_t size) noexcept {
+	std::size_t skipped = 0;
+	while (skipped < size && m_size) {
+		const auto s = m_head->buffer.skip(size - skipped);
+		skipped += s;
+		m_size -= s;
+		retire();
+	}
+	return skipped;
+}
+
+template <typename T, typename Allocator>
+const T* Chain<T, Allocator>::peek(std::size_t& size) const noexcept {
+	if (!m_head) {
+		size = 0;
+		return nullptr;
+	}
+	return m_head->buffer.peek(size);
+}
+
+template <typename T, typename Allocator>
+std::size_t Chain<T, Allocator>::size() const noexcept {
+	return m_size;
+}
+
+template <typename T, typename Allocator>
+bool Chain<T, Allocator>::empty() const noexcept {
+	return m_size == 0;
+}
+
+template <typename T, typename Allocator>
+std::size_t Chain<T, Allocator>::segments() const noexcept {
+	return m_segments;
+}
+
+template <typename T, typename Allocator>
+auto Chain<T, Allocator>::acquire() -> Segment* {
+	if (m_spare) {
+		const auto segment = m_spare;
+		m_spare = nullptr;
+		return segment;
+	}
+	const auto segment = segment_traits::allocate(m_allocator, 1);
+	try {
+		segment_traits::construct(m_allocator, segment, m_segment, Allocator(m_allocator));
+	} catch (...) {
+		segment_traits::deallocate(m_allocator, segment, 1);
+		throw;
+	}
+	return segment;
+}
+
+template <typename T, typename Allocator>
+void Chain<T, Allocator>::release(Segment* segment) noexcept {
+	segment_traits::destroy(m_allocator, segment);
+	segment_traits::deallocate(m_allocator, segment, 1);
+}
+
+template <typename T, typename Allocator>
+void Chain<T, Allocator>::retire() noexcept {
+	// Drained segments before the tail will never be written again.
+	while (m_head != m_tail && m_head->buffer.size() == 0) {
+		const auto segment = m_head;
+		m_head = segment->next;
+		segment->next = nullptr;
+		--m_segments;
+		if (m_spare) {
+			release(segment);
+		} else {
+			m_spare = segment;
+		}
+	}
+}
+
+} // namespace bip
+
+#endif // BIP_BUFFER_H_INCLUDED
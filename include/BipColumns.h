@@ -0,0 +1,186 @@
+/*
+ * Struct-of-arrays bi-partitioned circular buffer.
+ */
+
+#ifndef BIP_COLUMNS_H_INCLUDED
+#define BIP_COLUMNS_H_INCLUDED
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+
+#include "Bip.h"
+
+namespace bip {
+
+namespace internal {
+
+template <std::size_t... I>
+struct indices {};
+
+template <std::size_t N, std::size_t... I>
+struct make_indices : make_indices<N - 1, N - 1, I...> {};
+
+template <std::size_t... I>
+struct make_indices<0, I...> {
+    using type = indices<I...>;
+};
+
+} // namespace internal
+
+template <typename... Ts>
+class Columns {
+public:
+    using First = typename std::tuple_element<0, std::tuple<Ts...>>::type;
+
+    /*
+     * Construct a columnar buffer of 'size' tuples over the arrays 'columns', one of 'size' elements per field. The arrays
+     * may be carved from one block or allocated apart
+     */
+    Columns(std::size_t size, Ts*... columns) noexcept;
+
+    Columns(const Columns&) = delete;
+    Columns& operator=(const Columns&) = delete;
+
+    /*
+     * Attempt to write 'count' tuples, taking field i from column array 'data[i]'. Returns the count of actual tuples written
+     */
+    std::size_t put(std::size_t count, const Ts*... data) noexcept;
+
+    /*
+     * Attempt to read 'count' tuples into column arrays 'data'. Returns the count of actual tuples read
+     */
+    std::size_t get(std::size_t count, Ts*... data) noexcept;
+
+    /*
+     * Store the contiguous readable region of each column in 'spans'. Returns its tuple count. Consume it with skip()
+     */
+    std::size_t peek(const Ts*&... spans) const noexcept;
+
+    /*
+     * Attempt to skip 'count' tuples. Returns the count of actual tuples skipped
+     */
+    inline std::size_t skip(std::size_t count) noexcept;
+
+    /*
+     * Returns how many tuples are available for a single read
+     */
+    inline std::size_t avail() const noexcept;
+
+    /*
+     * Returns how many tuples can be written in a single write
+     */
+    inline std::size_t free() const noexcept;
+
+    /*
+     * Returns true if there are no tuples available for read
+     */
+    inline bool empty() const noexcept;
+
+    /*
+     * Returns true if there are any tuples to be read
+     */
+    inline bool have() const noexcept;
+
+private:
+    using Indices = typename internal::make_indices<sizeof...(Ts)>::type;
+
+    template <std::size_t... I>
+    void store(internal::indices<I...>, std::size_t offset, std::size_t count, const Ts*... data) noexcept;
+
+    template <std::size_t... I>
+    void load(internal::indices<I...>, std::size_t offset, std::size_t count, Ts*... data) const noexcept;
+
+    template <std::size_t... I>
+    void locate(internal::indices<I...>, std::size_t offset, const Ts*&... spans) const noexcept;
+
+    const std::tuple<Ts*...> m_columns;
+    BIP<First> m_cursor;
+}; // class Columns
+
+} // namespace bip
+
+namespace bip {
+
+template <typename... Ts>
+Columns<Ts...>::Columns(std::size_t size, Ts*... columns) noexcept :
+		m_columns{columns...},
+		m_cursor{std::get<0>(m_columns), size} {
+}
+
+template <typename... Ts>
+std::size_t Columns<Ts...>::put(std::size_t count, const Ts*... data) noexcept {
+	std::size_t size = 0;
+	const auto offset = static_cast<std::size_t>(m_cursor.reserve(size) - std::get<0>(m_columns));
+	const auto n = std::min(count, size);
+	store(Indices{}, offset, n, data...);
+	return m_cursor.commit(n);
+}
+
+template <typename... Ts>
+std::size_t Columns<Ts...>::get(std::size_t count, Ts*... data) noexcept {
+	std::size_t size = 0;
+	const auto offset = static_cast<std::size_t>(m_cursor.peek(size) - std::get<0>(m_columns));
+	const auto n = std::min(count, size);
+	load(Indices{}, offset, n, data...);
+	return m_cursor.skip(n);
+}
+
+template <typename... Ts>
+std::size_t Columns<Ts...>::peek(const Ts*&... spans) const noexcept {
+	std::size_t size = 0;
+	const auto offset = static_cast<std::size_t>(m_cursor.peek(size) - std::get<0>(m_columns));
+	locate(Indices{}, offset, spans...);
+	return size;
+}
+
+template <typename... Ts>
+std::size_t Columns<Ts...>::skip(std::size_t count) noexcept {
+	return m_cursor.skip(count);
+}
+
+template <typename... Ts>
+std::size_t Columns<Ts...>::avail() const noexcept {
+	return m_cursor.avail();
+}
+
+template <typename... Ts>
+std::size_t Columns<Ts...>::free() const noexcept {
+	return m_cursor.free();
+}
+
+template <typename... Ts>
+bool Columns<Ts...>::empty() const noexcept {
+	return m_cursor.empty();
+}
+
+template <typename... Ts>
+bool Columns<Ts...>::have() const noexcept {
+	return m_cursor.have();
+}
+
+template <typename... Ts>
+template <std::size_t... I>
+void Columns<Ts...>::store(internal::indices<I...>, std::size_t offset, std::size_t count, const Ts*... data) noexcept {
+	const int expand[] = {0, (memcpy(std::get<I>(m_columns) + offset, data, count * sizeof(Ts)), 0)...};
+	(void)expand;
+}
+
+template <typename... Ts>
+template <std::size_t... I>
+void Columns<Ts...>::load(internal::indices<I...>, std::size_t offset, std::size_t count, Ts*... data) const noexcept {
+	const int expand[] = {0, (memcpy(data, std::get<I>(m_columns) + offset, count * sizeof(Ts)), 0)...};
+	(void)expand;
+}
+
+template <typename... Ts>
+template <std::size_t... I>
+void Columns<Ts...>::locate(internal::indices<I...>, std::size_t offset, const Ts*&... spans) const noexcept {
+	const int expand[] = {0, (spans = std::get<I>(m_columns) + offset, 0)...};
+	(void)expand;
+}
+
+} // namespace bip
+
+#endif // BIP_COLUMNS_H_INCLUDED
@@ -0,0 +1,213 @@
+/*
+ * Write-behind consumer draining bi-partitioned circular buffers to a file opened with O_DIRECT.
+ */
+
+#ifndef BIP_DIRECT_H_INCLUDED
+#define BIP_DIRECT_H_INCLUDED
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace bip {
+
+/*
+ * Writes block multiples straight from the buffer's readable region while both it and the file offset are block
+ * aligned, bypassing the page cache. Anything else goes through an aligned staging buffer, where only the tail
+ * short of a block stays between drains. Where the file system refuses O_DIRECT, writes go through the page cache
+ */
+class DirectWriter {
+public:
+    static constexpr std::size_t default_block = 4096;
+    static constexpr std::size_t default_staging = 1024 * 1024;
+
+    /*
+     * Create or truncate the file at 'path'. Issue fdatasync every 'sync_every' bytes, or only on flush() if 0.
+     * 'block' is the O_DIRECT alignment, a power of two. Throws std::system_error on failure
+     */
+    explicit DirectWriter(const char* path, std::size_t sync_every = 0, std::size_t block = default_block,
+            std::size_t staging = default_staging);
+
+    /*
+     * Flush, ignoring errors, and close the file
+     */
+    ~DirectWriter();
+
+    DirectWriter(const DirectWriter&) = delete;
+    DirectWriter& operator=(const DirectWriter&) = delete;
+
+    /*
+     * Write everything readable from 'source', which has the peek(size)/skip(size) consumer interface of BIP<char>.
+     * Returns the byte count consumed. Throws std::system_error if a write fails
+     */
+    template <typename Source>
+    std::size_t drain(Source& source);
+
+    /*
+     * Write the staged tail, padded to a block then truncated off the file, and fdatasync. Later drains continue the file
+     */
+    void flush();
+
+    /*
+     * Returns true if the file is open with O_DIRECT
+     */
+    inline bool direct() const noexcept;
+
+    /*
+     * Returns the byte count consumed so far
+     */
+    inline std::uint64_t written() const noexcept;
+
+private:
+    void write(const char* data, std::size_t size);
+    void account(std::size_t size);
+
+    const std::size_t m_sync_every;
+    const std::size_t m_block;
+    const std::size_t m_capacity;
+    int m_fd;
+    bool m_direct;
+    char* m_staging;
+    std::size_t m_staged;
+    std::uint64_t m_offset;
+    std::size_t m_unsynced;
+}; // class DirectWriter
+
+} // namespace bip
+
+namespace bip {
+
+inline DirectWriter::DirectWriter(const char* path, std::size_t sync_every, std::size_t block, std::size_t staging) :
+		m_sync_every{sync_every},
+		m_block{block},
+		m_capacity{std::max(staging / block * block, block)},
+		m_fd{-1},
+		m_direct{true},
+		m_staging{},
+		m_staged{},
+		m_offset{},
+		m_unsynced{} {
+	void* memory = nullptr;
+	if (posix_memalign(&memory, m_block, m_capacity) != 0) {
+		throw std::bad_alloc{};
+	}
+	m_staging = static_cast<char*>(memory);
+	const auto flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+	m_fd = open(path, flags | O_DIRECT, 0644);
+	if (m_fd < 0 && errno == EINVAL) {
+		m_direct = false;
+		m_fd = open(path, flags, 0644);
+	}
+	if (m_fd < 0) {
+		const auto error = errno;
+		free(m_staging);
+		throw std::system_error{error, std::generic_category(), path};
+	}
+}
+
+inline DirectWriter::~DirectWriter() {
+	try {
+		flush();
+	} catch (const std::system_error&) {
+	}
+	close(m_fd);
+	free(m_staging);
+}
+
+template <typename Source>
+std::size_t DirectWriter::drain(Source& source) {
+	std::size_t consumed = 0;
+	for (;;) {
+		std::size_t size = 0;
+		const auto data = reinterpret_cast<const char*>(source.peek(size));
+		if (size == 0) {
+			break;
+		}
+		const auto aligned = (reinterpret_cast<std::uintptr_t>(data) & (m_block - 1)) == 0;
+		if (m_staged == 0 && aligned && size >= m_block) {
+			// Straight from the buffer.
+			const auto n = std::min(size / m_block * m_block, m_capacity);
+			write(data, n);
+			m_offset += n;
+			source.skip(n);
+			account(n);
+			consumed += n;
+			continue;
+		}
+		const auto n = std::min(size, m_capacity - m_staged);
+		memcpy(m_staging + m_staged, data, n);
+		m_staged += n;
+		source.skip(n);
+		consumed += n;
+		const auto blocks = m_staged / m_block * m_block;
+		if (blocks) {
+			write(m_staging, blocks);
+			m_offset += blocks;
+			m_staged -= blocks;
+			memmove(m_staging, m_staging + blocks, m_staged);
+			account(blocks);
+		}
+	}
+	return consumed;
+}
+
+inline void DirectWriter::flush() {
+	if (m_staged) {
+		// The tail stays staged, and its block is written again once it fills.
+		const auto padded = (m_staged + m_block - 1) / m_block * m_block;
+		memset(m_staging + m_staged, 0, padded - m_staged);
+		write(m_staging, padded);
+		if (ftruncate(m_fd, static_cast<off_t>(m_offset + m_staged)) != 0) {
+			throw std::system_error{errno, std::generic_category(), "ftruncate"};
+		}
+	}
+	if (fdatasync(m_fd) != 0) {
+		throw std::system_error{errno, std::generic_category(), "fdatasync"};
+	}
+	m_unsynced = 0;
+}
+
+bool DirectWriter::direct() const noexcept {
+	return m_direct;
+}
+
+std::uint64_t DirectWriter::written() const noexcept {
+	return m_offset + m_staged;
+}
+
+inline void DirectWriter::write(const char* data, std::size_t size) {
+	auto offset = m_offset;
+	while (size) {
+		const auto w = pwrite(m_fd, data, size, static_cast<off_t>(offset));
+		if (w < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			throw std::system_error{errno, std::generic_category(), "pwrite"};
+		}
+		data += w;
+		size -= static_cast<std::size_t>(w);
+		offset += static_cast<std::uint64_t>(w);
+	}
+}
+
+inline void DirectWriter::account(std::size_t size) {
+	m_unsynced += size;
+	if (m_sync_every && m_unsynced >= m_sync_every) {
+		if (fdatasync(m_fd) != 0) {
+			throw std::system_error{errno, std::generic_category(), "fdatasync"};
+		}
+		m_unsynced = 0;
+	}
+}
+
+} // namespace bip
+
+#endif // BIP_DIRECT_H_INCLUDED
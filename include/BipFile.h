@@ -0,0 +1,122 @@
+/*
+ * Standard C FILE* streams over bi-partitioned circular buffers.
+ */
+
+#ifndef BIP_FILE_H_INCLUDED
+#define BIP_FILE_H_INCLUDED
+
+#include <cerrno>
+#include <cstdio>
+
+#include <sys/types.h>
+
+#include "Bip.h"
+#include "BipBlocking.h"
+
+namespace bip {
+
+/*
+ * Open an unbuffered stream over 'bip', which must outlive it. Writes copy straight into the Put partition and
+ * fail with ENOSPC past the free space, reads take from the Get partition and see end of file when it is empty.
+ * 'mode' is as for fopen(). Returns nullptr on failure
+ */
+inline FILE* open_file(BIP<char>& bip, const char* mode = "w");
+
+/*
+ * As above over a blocking buffer, with writes waiting for space and reads for data until the buffer is closed
+ */
+inline FILE* open_file(Blocking<char>& blocking, const char* mode = "w");
+
+namespace internal {
+
+template <typename Buffer>
+struct Cookie;
+
+template <>
+struct Cookie<BIP<char>> {
+    static inline ssize_t write(void* cookie, const char* data, std::size_t size);
+    static inline ssize_t read(void* cookie, char* data, std::size_t size);
+}; // struct Cookie<BIP<char>>
+
+template <>
+struct Cookie<Blocking<char>> {
+    static inline ssize_t write(void* cookie, const char* data, std::size_t size);
+    static inline ssize_t read(void* cookie, char* data, std::size_t size);
+}; // struct Cookie<Blocking<char>>
+
+/*
+ * Open an unbuffered stream over 'buffer' with the functions of Cookie<Buffer>
+ */
+template <typename Buffer>
+FILE* open_file(Buffer& buffer, const char* mode);
+
+} // namespace internal
+
+} // namespace bip
+
+namespace bip {
+
+namespace internal {
+
+ssize_t Cookie<BIP<char>>::write(void* cookie, const char* data, std::size_t size) {
+	auto& bip = *static_cast<BIP<char>*>(cookie);
+	// The second put continues in the other partition after a switch.
+	auto written = bip.put(data, size);
+	if (written < size) {
+		written += bip.put(data + written, size - written);
+	}
+	if (written == 0 && size != 0) {
+		errno = ENOSPC;
+		return -1;
+	}
+	return static_cast<ssize_t>(written);
+}
+
+ssize_t Cookie<BIP<char>>::read(void* cookie, char* data, std::size_t size) {
+	auto& bip = *static_cast<BIP<char>*>(cookie);
+	auto read = bip.get(data, size);
+	if (read < size) {
+		read += bip.get(data + read, size - read);
+	}
+	return static_cast<ssize_t>(read);
+}
+
+ssize_t Cookie<Blocking<char>>::write(void* cookie, const char* data, std::size_t size) {
+	const auto written = static_cast<Blocking<char>*>(cookie)->put(data, size);
+	if (written == 0 && size != 0) {
+		errno = EPIPE;
+		return -1;
+	}
+	return static_cast<ssize_t>(written);
+}
+
+ssize_t Cookie<Blocking<char>>::read(void* cookie, char* data, std::size_t size) {
+	return static_cast<ssize_t>(static_cast<Blocking<char>*>(cookie)->get(data, size));
+}
+
+template <typename Buffer>
+FILE* open_file(Buffer& buffer, const char* mode) {
+	cookie_io_functions_t functions{};
+	functions.read = Cookie<Buffer>::read;
+	functions.write = Cookie<Buffer>::write;
+	const auto file = fopencookie(&buffer, mode, functions);
+	// Data goes straight to the buffer, which already does the buffering.
+	if (file) {
+		setvbuf(file, nullptr, _IONBF, 0);
+	}
+	return file;
+}
+
+} // namespace internal
+
+FILE* open_file(BIP<char>& bip, const char* mode) {
+	return internal::open_file(bip, mode);
+}
+
+FILE* open_file(Blocking<char>& blocking, const char* mode) {
+	return internal::open_file(blocking, mode);
+}
+
+} // namespace bip
+
+#endif // BIP_FILE_H_INCLUDED
@@ -0,0 +1,546 @@
+/*
+ * Circular buffer in a file, broadcast to named consumer cursors checkpointed across restarts.
+ */
+
+#ifndef BIP_GROUP_H_INCLUDED
+#define BIP_GROUP_H_INCLUDED
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace bip {
+
+namespace internal {
+
+/*
+ * Metadata of one named cursor. Each takes a cache line of its own, as its consumer may run in another process.
+ * A slot is only claimed while process 'owner' opens a cursor in it
+ */
+struct GroupSlot {
+    static constexpr std::uint32_t free = 0;
+    static constexpr std::uint32_t claimed = 1;
+    static constexpr std::uint32_t live = 2;
+    static constexpr std::size_t name_size = 48;
+
+    alignas(64) std::atomic<std::uint32_t> state;
+    std::atomic<std::int32_t> owner;
+    char name[name_size];
+    std::atomic<std::uint64_t> checkpoint;
+}; // struct GroupSlot
+
+struct GroupHeader {
+    static constexpr std::uint32_t signature = 0x42495047; // "BIPG"
+    static constexpr std::size_t slots = 16;
+
+    std::uint32_t magic;
+    std::uint32_t element;
+    std::uint64_t size;
+    std::atomic<std::int32_t> opener; // process opening a cursor, or 0
+    alignas(64) std::atomic<std::uint64_t> head;
+    GroupSlot slot[slots];
+}; // struct GroupHeader
+
+/*
+ * Returns false if process 'pid' no longer exists
+ */
+inline bool running(std::int32_t pid) noexcept;
+
+} // namespace internal
+
+/*
+ * Elements are addressed by 64-bit offsets counted from the first one ever written, which stay valid in the file
+ * across restarts where BIP<T>'s pointers would not. Every live cursor reads all of them, and the producer only reuses
+ * space behind the slowest live cursor's last checkpoint, so a consumer reopened after a restart resumes from its
+ * checkpoint and sees again whatever it read after it. One producer, and one consumer per cursor, may run concurrently
+ * in different processes, which must share a PID namespace. Data and checkpoints live in the shared mapping, so they
+ * survive a process crash as soon as written, but survive a power loss only once sync() returned
+ */
+template <typename T>
+class Group {
+public:
+    class Cursor;
+
+    /*
+     * Create a group of 'size' elements in the file referred to by 'fd', resizing it to fit.
+     * Throws std::system_error on failure
+     */
+    Group(int fd, std::size_t size);
+
+    /*
+     * Reopen the group created in the file referred to by 'fd', with its data and cursors.
+     * Throws std::system_error on failure
+     */
+    explicit Group(int fd);
+
+    ~Group();
+
+    Group(const Group&) = delete;
+    Group& operator=(const Group&) = delete;
+
+    /*
+     * Producer: attempt to write 'size' elements from 'data'. Returns the count of actual elements written
+     */
+    std::size_t put(const T* data, std::size_t size) noexcept;
+
+    /*
+     * Producer: returns the contiguous region available for writing and stores its element count in 'size'
+     */
+    T* reserve(std::size_t& size) noexcept;
+
+    /*
+     * Producer: mark 'size' elements of the reserved region as written. Returns the count of actual elements committed
+     */
+    std::size_t commit(std::size_t size) noexcept;
+
+    /*
+     * Producer: returns how many elements can be written in total, ahead of the slowest live checkpoint
+     */
+    inline std::size_t space() noexcept;
+
+    /*
+     * Returns the offset the next element will be written at
+     */
+    inline std::uint64_t head() const noexcept;
+
+    /*
+     * Returns the offset of the slowest live checkpoint, or head() if there are no cursors
+     */
+    std::uint64_t tail() const noexcept;
+
+    /*
+     * Write the data and checkpoints through to the file, so that they survive a power loss.
+     * Throws std::system_error on failure
+     */
+    void sync();
+
+private:
+    static constexpr std::size_t header = (sizeof(internal::GroupHeader) + alignof(T) - 1) / alignof(T) * alignof(T);
+
+    void map(int fd, std::size_t bytes);
+
+    /*
+     * Serialize opening cursors across processes, taking over from an opener that died
+     */
+    void lock() noexcept;
+
+    void unlock() noexcept;
+
+    void* m_memory;
+    std::size_t m_bytes;
+    internal::GroupHeader* m_header;
+    T* m_data;
+    std::size_t m_size;
+    std::uint64_t m_tail;
+}; // class Group
+
+/*
+ * A named consumer of a group. Opening a name that exists resumes from its checkpoint, otherwise the cursor starts at
+ * the head. Finding or claiming the name is one step under the group's opener lock, so concurrent opens of a new name
+ * agree on one slot, and a slot left claimed by an opener that died is reused. Only one cursor of a name may be open
+ * at a time
+ */
+template <typename T>
+class Group<T>::Cursor {
+public:
+    /*
+     * Open cursor 'name' of 'group', which must outlive it, checkpointing every 'every' elements consumed,
+     * or only on checkpoint() if 0. Throws std::system_error if the name is too long or all cursors are taken
+     */
+    Cursor(Group& group, const char* name, std::size_t every = 0);
+
+    /*
+     * Checkpoint, unless removed
+     */
+    ~Cursor();
+
+    Cursor(const Cursor&) = delete;
+    Cursor& operator=(const Cursor&) = delete;
+
+    /*
+     * Attempt to read 'size' elements into 'data'. Returns the count of actual elements read
+     */
+    std::size_t get(T* data, std::size_t size) noexcept;
+
+    /*
+     * Attempt to skip 'size' elements. Returns the count of actual elements skipped
+     */
+    std::size_t skip(std::size_t size) noexcept;
+
+    /*
+     * Returns the contiguous region available for reading and stores its element count in 'size'.
+     * Consume it with skip()
+     */
+    inline const T* peek(std::size_t& size) noexcept;
+
+    /*
+     * Store both readable regions in order in 'first' and 'second', with their element counts.
+     * Returns the total count of elements available for reading
+     */
+    inline std::size_t peek(const T*& first, std::size_t& first_size, const T*& second, std::size_t& second_size) noexcept;
+
+    /*
+     * Returns how many elements are available for reading in total
+     */
+    inline std::size_t size() const noexcept;
+
+    /*
+     * Returns true if there are no elements available for read
+     */
+    inline bool empty() const noexcept;
+
+    /*
+     * Returns true if there are any elements to be read
+     */
+    inline bool have() const noexcept;
+
+    /*
+     * Record the current position, where the cursor resumes when reopened. It survives a power loss only after
+     * Group::sync()
+     */
+    inline void checkpoint() noexcept;
+
+    /*
+     * Drop the cursor from the group, so that it no longer holds back the producer. The object must not be used after
+     */
+    inline void remove() noexcept;
+
+    /*
+     * Returns the offset of the next element to be read
+     */
+    inline std::uint64_t position() const noexcept;
+
+    /*
+     * Returns the offset the cursor resumes from when reopened
+     */
+    inline std::uint64_t checkpointed() const noexcept;
+
+private:
+    Group& m_group;
+    internal::GroupSlot* m_slot;
+    const std::size_t m_every;
+    std::uint64_t m_position;
+    std::uint64_t m_checkpoint;
+}; // class Group<T>::Cursor
+
+} // namespace bip
+
+namespace bip {
+
+namespace internal {
+
+bool running(std::int32_t pid) noexcept {
+	// EPERM means the process exists but belongs to someone else.
+	return pid > 0 && (kill(static_cast<pid_t>(pid), 0) == 0 || errno != ESRCH);
+}
+
+} // namespace internal
+
+template <typename T>
+constexpr std::size_t Group<T>::header;
+
+template <typename T>
+Group<T>::Group(int fd, std::size_t size) :
+		m_memory{},
+		m_bytes{},
+		m_header{},
+		m_data{},
+		m_size{size},
+		m_tail{} {
+	static_assert(std::is_trivially_copyable<T>::value, "Elements are copied with memcpy");
+	const auto bytes = header + size * sizeof(T);
+	if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+		throw std::system_error{errno, std::generic_category(), "ftruncate"};
+	}
+	map(fd, bytes);
+	m_header = new (m_memory) internal::GroupHeader{};
+	m_header->element = sizeof(T);
+	m_header->size = size;
+	m_header->opener.store(0, std::memory_order_relaxed);
+	m_header->head.store(0, std::memory_order_relaxed);
+	for (auto& slot : m_header->slot) {
+		slot.state.store(internal::GroupSlot::free, std::memory_order_relaxed);
+		slot.owner.store(0, std::memory_order_relaxed);
+		slot.checkpoint.store(0, std::memory_order_relaxed);
+	}
+	__atomic_store_n(&m_header->magic, internal::GroupHeader::signature, __ATOMIC_RELEASE);
+	m_data = reinterpret_cast<T*>(static_cast<unsigned char*>(m_memory) + header);
+}
+
+template <typename T>
+Group<T>::Group(int fd) :
+		m_memory{},
+		m_bytes{},
+		m_header{},
+		m_data{},
+		m_size{},
+		m_tail{} {
+	struct stat st{};
+	if (fstat(fd, &st) != 0) {
+		throw std::system_error{errno, std::generic_category(), "fstat"};
+	}
+	map(fd, static_cast<std::size_t>(st.st_size));
+	m_header = static_cast<internal::GroupHeader*>(m_memory);
+	if (m_bytes < header || __atomic_load_n(&m_header->magic, __ATOMIC_ACQUIRE) != internal::GroupHeader::signature ||
+			m_header->element != sizeof(T) || header + m_header->size * sizeof(T) > m_bytes) {
+		munmap(m_memory, m_bytes);
+		throw std::system_error{EINVAL, std::generic_category(), "Not a BIP consumer group"};
+	}
+	m_data = reinterpret_cast<T*>(static_cast<unsigned char*>(m_memory) + header);
+	m_size = m_header->size;
+	m_tail = tail();
+}
+
+template <typename T>
+Group<T>::~Group() {
+	munmap(m_memory, m_bytes);
+}
+
+template <typename T>
+std::size_t Group<T>::put(const T* data, std::size_t size) noexcept {
+	std::size_t written = 0;
+	// The second pass continues at the start of the file after the end.
+	for (int pass = 0; pass < 2 && written < size; ++pass) {
+		std::size_t f = 0;
+		const auto out = reserve(f);
+		const auto n = std::min(size - written, f);
+		if (n == 0) {
+			break;
+		}
+		memcpy(out, data + written, n * sizeof(T));
+		written += commit(n);
+	}
+	return written;
+}
+
+template <typename T>
+T* Group<T>::reserve(std::size_t& size) noexcept {
+	const auto head = m_header->head.load(std::memory_order_relaxed);
+	const auto index = static_cast<std::size_t>(head % m_size);
+	const auto contiguous = m_size - index;
+	// Scan the checkpoints only when the cached tail leaves less than the contiguous region.
+	if (m_size - (head - m_tail) < contiguous) {
+		m_tail = tail();
+	}
+	size = std::min(contiguous, m_size - static_cast<std::size_t>(head - m_tail));
+	return m_data + index;
+}
+
+template <typename T>
+std::size_t Group<T>::commit(std::size_t size) noexcept {
+	std::size_t f = 0;
+	reserve(f);
+	const auto n = std::min(size, f);
+	m_header->head.fetch_add(n, std::memory_order_seq_cst);
+	return n;
+}
+
+template <typename T>
+std::size_t Group<T>::space() noexcept {
+	m_tail = tail();
+	return m_size - static_cast<std::size_t>(head() - m_tail);
+}
+
+template <typename T>
+std::uint64_t Group<T>::head() const noexcept {
+	return m_header->head.load(std::memory_order_acquire);
+}
+
+template <typename T>
+std::uint64_t Group<T>::tail() const noexcept {
+	auto tail = m_header->head.load(std::memory_order_relaxed);
+	for (const auto& slot : m_header->slot) {
+		if (slot.state.load(std::memory_order_seq_cst) == internal::GroupSlot::live) {
+			tail = std::min(tail, slot.checkpoint.load(std::memory_order_acquire));
+		}
+	}
+	return tail;
+}
+
+template <typename T>
+void Group<T>::sync() {
+	if (msync(m_memory, m_bytes, MS_SYNC) != 0) {
+		throw std::system_error{errno, std::generic_category(), "msync"};
+	}
+}
+
+template <typename T>
+void Group<T>::map(int fd, std::size_t bytes) {
+	m_memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (m_memory == MAP_FAILED) {
+		m_memory = nullptr;
+		throw std::system_error{errno, std::generic_category(), "mmap"};
+	}
+	m_bytes = bytes;
+}
+
+template <typename T>
+void Group<T>::lock() noexcept {
+	const auto self = static_cast<std::int32_t>(getpid());
+	for (;;) {
+		auto holder = std::int32_t{0};
+		if (m_header->opener.compare_exchange_weak(holder, self, std::memory_order_acquire)) {
+			return;
+		}
+		if (holder != 0 && !internal::running(holder) &&
+				m_header->opener.compare_exchange_strong(holder, self, std::memory_order_acquire)) {
+			return;
+		}
+		std::this_thread::yield();
+	}
+}
+
+template <typename T>
+void Group<T>::unlock() noexcept {
+	m_header->opener.store(0, std::memory_order_release);
+}
+
+template <typename T>
+Group<T>::Cursor::Cursor(Group& group, const char* name, std::size_t every) :
+		m_group(group),
+		m_slot{},
+		m_every{every},
+		m_position{},
+		m_checkpoint{} {
+	using internal::GroupSlot;
+	if (strlen(name) >= GroupSlot::name_size) {
+		throw std::system_error{ENAMETOOLONG, std::generic_category(), name};
+	}
+	const auto self = static_cast<std::int32_t>(getpid());
+	auto& slots = group.m_header->slot;
+	group.lock();
+	for (auto& slot : slots) {
+		if (slot.state.load(std::memory_order_acquire) == GroupSlot::live && strcmp(slot.name, name) == 0) {
+			group.unlock();
+			m_slot = &slot;
+			m_position = m_checkpoint = slot.checkpoint.load(std::memory_order_relaxed);
+			return;
+		}
+	}
+	for (auto& slot : slots) {
+		const auto state = slot.state.load(std::memory_order_acquire);
+		// Slots are only claimed under the lock, so one still claimed belongs to an opener that died.
+		if (state == GroupSlot::live ||
+				(state == GroupSlot::claimed && internal::running(slot.owner.load(std::memory_order_relaxed)))) {
+			continue;
+		}
+		slot.owner.store(self, std::memory_order_relaxed);
+		slot.state.store(GroupSlot::claimed, std::memory_order_seq_cst);
+		m_slot = &slot;
+		break;
+	}
+	if (!m_slot) {
+		group.unlock();
+		throw std::system_error{ENOSPC, std::generic_category(), "No free cursor in the group"};
+	}
+	strcpy(m_slot->name, name);
+	// Holding the head until live, then starting from the head as seen after, never lets the producer overwrite unread data.
+	m_slot->checkpoint.store(group.m_header->head.load(std::memory_order_seq_cst), std::memory_order_relaxed);
+	m_slot->state.store(GroupSlot::live, std::memory_order_seq_cst);
+	group.unlock();
+	m_position = group.m_header->head.load(std::memory_order_seq_cst);
+	checkpoint();
+}
+
+template <typename T>
+Group<T>::Cursor::~Cursor() {
+	if (m_slot) {
+		checkpoint();
+	}
+}
+
+template <typename T>
+std::size_t Group<T>::Cursor::get(T* data, std::size_t size) noexcept {
+	std::size_t read = 0;
+	// The second pass continues at the start of the file after the end.
+	for (int pass = 0; pass < 2 && read < size; ++pass) {
+		std::size_t a = 0;
+		const auto in = peek(a);
+		const auto n = std::min(size - read, a);
+		if (n == 0) {
+			break;
+		}
+		memcpy(data + read, in, n * sizeof(T));
+		read += skip(n);
+	}
+	return read;
+}
+
+template <typename T>
+std::size_t Group<T>::Cursor::skip(std::size_t size) noexcept {
+	const auto n = std::min(size, this->size());
+	m_position += n;
+	if (m_every && m_position - m_checkpoint >= m_every) {
+		checkpoint();
+	}
+	return n;
+}
+
+template <typename T>
+const T* Group<T>::Cursor::peek(std::size_t& size) noexcept {
+	const auto index = static_cast<std::size_t>(m_position % m_group.m_size);
+	size = std::min(this->size(), m_group.m_size - index);
+	return m_group.m_data + index;
+}
+
+template <typename T>
+std::size_t Group<T>::Cursor::peek(const T*& first, std::size_t& first_size, const T*& second, std::size_t& second_size) noexcept {
+	const auto total = size();
+	first = peek(first_size);
+	second = m_group.m_data;
+	second_size = total - first_size;
+	return total;
+}
+
+template <typename T>
+std::size_t Group<T>::Cursor::size() const noexcept {
+	return static_cast<std::size_t>(m_group.head() - m_position);
+}
+
+template <typename T>
+bool Group<T>::Cursor::empty() const noexcept {
+	return size() == 0;
+}
+
+template <typename T>
+bool Group<T>::Cursor::have() const noexcept {
+	return !empty();
+}
+
+template <typename T>
+void Group<T>::Cursor::checkpoint() noexcept {
+	m_checkpoint = m_position;
+	m_slot->checkpoint.store(m_position, std::memory_order_release);
+}
+
+template <typename T>
+void Group<T>::Cursor::remove() noexcept {
+	m_slot->state.store(internal::GroupSlot::free, std::memory_order_release);
+	m_slot = nullptr;
+}
+
+template <typename T>
+std::uint64_t Group<T>::Cursor::position() const noexcept {
+	return m_position;
+}
+
+template <typename T>
+std::uint64_t Group<T>::Cursor::checkpointed() const noexcept {
+	return m_checkpoint;
+}
+
+} // namespace bip
+
+#endif // BIP_GROUP_H_INCLUDED
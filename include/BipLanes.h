@@ -0,0 +1,202 @@
+/*
+ * Priority lanes of bi-partitioned circular buffers sharing one storage block.
+ */
+
+#ifndef BIP_LANES_H_INCLUDED
+#define BIP_LANES_H_INCLUDED
+
+#include <array>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+#include "Bip.h"
+
+namespace bip {
+
+template <typename T, std::size_t K>
+class Lanes {
+public:
+    /*
+     * Carve memory block 'buf' of 'size' elements into K lanes, lane i receiving 'shares[i]' parts of it.
+     * Lane 0 has the highest priority. With 'borrow', a full lane may spill into an idle lower priority lane. Puts
+     * go back to the lane's own storage once it is drained, and the loan is returned as soon as it is drained in turn
+     */
+    Lanes(T* buf, std::size_t size, const std::array<std::size_t, K>& shares, bool borrow = false) noexcept;
+
+    Lanes(const Lanes&) = delete;
+    Lanes& operator=(const Lanes&) = delete;
+
+    /*
+     * Attempt to write 'size' elements from 'data' into lane 'lane'. Returns the count of actual elements written
+     */
+    std::size_t put(std::size_t lane, const T* data, std::size_t size) noexcept;
+
+    /*
+     * Attempt to read 'size' elements of the highest priority non-empty lane into 'data'.
+     * Stores that lane in 'lane' if given. Returns the count of actual elements read
+     */
+    std::size_t get(T* data, std::size_t size, std::size_t* lane = nullptr) noexcept;
+
+    /*
+     * Returns true if lane 'lane' has any elements to be read
+     */
+    inline bool have(std::size_t lane) const noexcept;
+
+    /*
+     * Returns true if there are no elements available for read in any lane
+     */
+    inline bool empty() const noexcept;
+
+    /*
+     * Returns the element count of lane 'lane' storage
+     */
+    inline std::size_t capacity(std::size_t lane) const noexcept;
+
+private:
+    inline BIP<T>& ring(std::size_t lane) noexcept;
+    inline const BIP<T>& ring(std::size_t lane) const noexcept;
+
+    /*
+     * Returns the lowest priority idle lane below 'lane', or K if there is none
+     */
+    inline std::size_t idle(std::size_t lane) const noexcept;
+
+    typename std::aligned_storage<sizeof(BIP<T>), alignof(BIP<T>)>::type m_rings[K];
+    std::array<std::size_t, K> m_capacity;
+    std::array<std::size_t, K> m_loan;
+    std::array<bool, K> m_lent;
+    std::array<bool, K> m_spill;
+    const bool m_borrow;
+}; // class Lanes
+
+} // namespace bip
+
+namespace bip {
+
+template <typename T, std::size_t K>
+Lanes<T, K>::Lanes(T* buf, std::size_t size, const std::array<std::size_t, K>& shares, bool borrow) noexcept :
+		m_rings{},
+		m_capacity{},
+		m_loan{},
+		m_lent{},
+		m_spill{},
+		m_borrow{borrow} {
+	static_assert(K > 0, "At least one lane is required");
+	static_assert(std::is_trivially_destructible<BIP<T>>::value, "Lanes doesn't destroy its rings");
+	std::size_t total = 0;
+	for (auto share : shares) {
+		total += share;
+	}
+	std::size_t offset = 0;
+	for (std::size_t i = 0; i < K; ++i) {
+		// The last lane takes the rounding remainder.
+		m_capacity[i] = i + 1 < K ? (total ? size / total * shares[i] + size % total * shares[i] / total : 0) : size - offset;
+		new (&m_rings[i]) BIP<T>{buf + offset, m_capacity[i]};
+		offset += m_capacity[i];
+		m_loan[i] = K;
+		m_lent[i] = false;
+		m_spill[i] = false;
+	}
+}
+
+template <typename T, std::size_t K>
+std::size_t Lanes<T, K>::put(std::size_t lane, const T* data, std::size_t size) noexcept {
+	if (m_lent[lane]) {
+		return 0;
+	}
+	// The loan holds data newer than the own ring's until that drains, older after.
+	if (m_spill[lane]) {
+		if (!ring(lane).empty()) {
+			return ring(m_loan[lane]).put(data, size);
+		}
+		m_spill[lane] = false;
+	}
+	auto written = ring(lane).put(data, size);
+	if (written < size) {
+		// A partition switch may have made room.
+		written += ring(lane).put(data + written, size - written);
+		if (written < size && m_borrow && m_loan[lane] == K) {
+			const auto lender = idle(lane);
+			if (lender != K) {
+				m_loan[lane] = lender;
+				m_lent[lender] = true;
+				m_spill[lane] = true;
+				written += ring(lender).put(data + written, size - written);
+			}
+		}
+	}
+	return written;
+}
+
+template <typename T, std::size_t K>
+std::size_t Lanes<T, K>::get(T* data, std::size_t size, std::size_t* lane) noexcept {
+	for (std::size_t i = 0; i < K; ++i) {
+		if (m_lent[i]) {
+			continue;
+		}
+		std::size_t read = 0;
+		if (m_loan[i] == K || (m_spill[i] && ring(i).have())) {
+			read = ring(i).get(data, size);
+		} else {
+			auto& loan = ring(m_loan[i]);
+			read = loan.get(data, size);
+			if (loan.empty()) {
+				m_lent[m_loan[i]] = false;
+				m_loan[i] = K;
+				m_spill[i] = false;
+			}
+		}
+		if (read) {
+			if (lane) {
+				*lane = i;
+			}
+			return read;
+		}
+	}
+	return 0;
+}
+
+template <typename T, std::size_t K>
+bool Lanes<T, K>::have(std::size_t lane) const noexcept {
+	return !m_lent[lane] && (ring(lane).have() || (m_loan[lane] != K && ring(m_loan[lane]).have()));
+}
+
+template <typename T, std::size_t K>
+bool Lanes<T, K>::empty() const noexcept {
+	for (std::size_t i = 0; i < K; ++i) {
+		if (have(i)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+template <typename T, std::size_t K>
+std::size_t Lanes<T, K>::capacity(std::size_t lane) const noexcept {
+	return m_capacity[lane];
+}
+
+template <typename T, std::size_t K>
+BIP<T>& Lanes<T, K>::ring(std::size_t lane) noexcept {
+	return *reinterpret_cast<BIP<T>*>(&m_rings[lane]);
+}
+
+template <typename T, std::size_t K>
+const BIP<T>& Lanes<T, K>::ring(std::size_t lane) const noexcept {
+	return *reinterpret_cast<const BIP<T>*>(&m_rings[lane]);
+}
+
+template <typename T, std::size_t K>
+std::size_t Lanes<T, K>::idle(std::size_t lane) const noexcept {
+	for (std::size_t i = K; i-- > lane + 1;) {
+		if (!m_lent[i] && m_loan[i] == K && ring(i).empty() && m_capacity[i]) {
+			return i;
+		}
+	}
+	return K;
+}
+
+} // namespace bip
+
+#endif // BIP_LANES_H_INCLUDED
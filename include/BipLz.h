@@ -0,0 +1,445 @@
+/*
+ * LZ77 block compression between bi-partitioned circular buffers.
+ *
+ * Every frame is independently decodable:
+ *   u32 raw size | u32 payload size | payload
+ * A payload as long as the raw size is stored uncompressed. Otherwise it is a sequence of
+ *   token (literal count << 4 | match length - 4) | literal count extension | literals | u16 offset | match length extension
+ * where the last sequence of a frame has literals only and extensions are runs of bytes added to 15 until one is below 255.
+ */
+
+#ifndef BIP_LZ_H_INCLUDED
+#define BIP_LZ_H_INCLUDED
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "Bip.h"
+
+namespace bip {
+
+constexpr std::size_t lz_header = 8;
+
+/*
+ * Returns the largest possible payload of a 'size' bytes block
+ */
+constexpr std::size_t lz_bound(std::size_t size) noexcept {
+    return size + size / 255 + 16;
+}
+
+/*
+ * Compress 'size' bytes from 'in' into 'out', which must hold lz_bound('size') bytes. Returns the payload size.
+ * 'table' holds 1 << LzCompressor::hash_bits positions counted from 'base', which advances by 'size' so entries
+ * left by earlier blocks fall below it and miss. Zero both before the first call
+ */
+inline std::size_t lz_compress(const char* in, std::size_t size, char* out, std::uint32_t* table,
+        std::uint32_t& base) noexcept;
+
+/*
+ * Decompress payload 'in' of 'size' bytes into 'out' of 'raw' bytes. Returns false if the payload is malformed
+ */
+inline bool lz_decompress(const char* in, std::size_t size, char* out, std::size_t raw) noexcept;
+
+class LzCompressor {
+public:
+    static constexpr std::size_t max_block = 0xffff;
+    static constexpr unsigned hash_bits = 14;
+
+    /*
+     * Compress input in blocks of 'block' (at most max_block) bytes
+     */
+    explicit LzCompressor(std::size_t block = max_block);
+
+    /*
+     * Compress data from 'in' into frames in 'out'. Only full blocks are compressed unless 'flush' is set.
+     * Returns the count of input bytes consumed
+     */
+    std::size_t compress(BIP<char>& in, BIP<char>& out, bool flush = false);
+
+    /*
+     * Returns true if no input is staged and no frame is waiting for output space
+     */
+    inline bool idle() const noexcept;
+
+private:
+    void frame(const char* data, std::size_t size, BIP<char>& out);
+    bool drain(BIP<char>& out);
+
+    const std::size_t m_block;
+    std::vector<char> m_staged;
+    std::size_t m_fill;
+    std::vector<char> m_frame;
+    std::size_t m_frame_pos;
+    std::vector<std::uint32_t> m_table;
+    std::uint32_t m_base;
+}; // class LzCompressor
+
+class LzDecompressor {
+public:
+    /*
+     * Decompress frames of up to 'block' bytes
+     */
+    explicit LzDecompressor(std::size_t block = LzCompressor::max_block);
+
+    /*
+     * Decompress frames from 'in' into 'out'. Returns the count of output bytes produced, stopping on malformed input
+     */
+    std::size_t decompress(BIP<char>& in, BIP<char>& out);
+
+    /*
+     * Returns true if malformed input was encountered
+     */
+    inline bool failed() const noexcept;
+
+private:
+    bool drain(BIP<char>& out, std::size_t& produced);
+
+    const std::size_t m_block;
+    std::vector<char> m_frame;
+    std::size_t m_fill;
+    std::vector<char> m_raw;
+    std::size_t m_raw_pos;
+    std::size_t m_raw_size;
+    bool m_failed;
+}; // class LzDecompressor
+
+namespace internal {
+
+inline std::uint32_t lz_load32(const char* p) noexcept {
+    std::uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline std::uint64_t lz_load64(const char* p) noexcept {
+    std::uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline void lz_store32(char* p, std::uint32_t value) noexcept {
+    const unsigned char bytes[] = {
+        static_cast<unsigned char>(value), static_cast<unsigned char>(value >> 8),
+        static_cast<unsigned char>(value >> 16), static_cast<unsigned char>(value >> 24)};
+    memcpy(p, bytes, sizeof(bytes));
+}
+
+inline std::uint32_t lz_read32(const char* p) noexcept {
+    const auto b = reinterpret_cast<const unsigned char*>(p);
+    return b[0] | b[1] << 8 | b[2] << 16 | static_cast<std::uint32_t>(b[3]) << 24;
+}
+
+inline char* lz_length(char* out, std::size_t length) noexcept {
+    for (; length >= 255; length -= 255) {
+        *out++ = static_cast<char>(255);
+    }
+    *out++ = static_cast<char>(length);
+    return out;
+}
+
+} // namespace internal
+
+} // namespace bip
+
+namespace bip {
+
+std::size_t lz_compress(const char* in, std::size_t size, char* out, std::uint32_t* table,
+		std::uint32_t& base) noexcept {
+	constexpr unsigned shift = 32 - LzCompressor::hash_bits;
+	constexpr std::size_t min_match = 4;
+	if (base > UINT32_MAX - size) {
+		// Clear only when positions would wrap, once every 4 GiB of input.
+		std::fill(table, table + (1u << LzCompressor::hash_bits), 0);
+		base = 0;
+	}
+	const auto origin = base;
+	base += static_cast<std::uint32_t>(size);
+	const auto start = out;
+	const char* anchor = in;
+	const char* ip = in + 1;
+	// Leave room for a full word read past the match candidate.
+	const char* const limit = size >= min_match + 8 ? in + size - min_match - 8 : in;
+	while (ip < limit) {
+		const auto word = internal::lz_load32(ip);
+		const auto h = (word * 2654435761u) >> shift;
+		const auto candidate = table[h];
+		table[h] = origin + static_cast<std::uint32_t>(ip - in);
+		const char* ref = candidate < origin ? ip : in + (candidate - origin);
+		if (ref >= ip || ip - ref > 0xffff || internal::lz_load32(ref) != word) {
+			// Step faster through incompressible data.
+			ip += 1 + ((ip - anchor) >> 6);
+			continue;
+		}
+		const char* const end = in + size;
+		auto match = min_match;
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+		while (ip + match + 8 <= end) {
+			const auto diff = internal::lz_load64(ip + match) ^ internal::lz_load64(ref + match);
+			if (diff) {
+				match += __builtin_ctzll(diff) >> 3;
+				break;
+			}
+			match += 8;
+		}
+#endif
+		while (ip + match < end && ip[match] == ref[match]) {
+			++match;
+		}
+		const auto literals = static_cast<std::size_t>(ip - anchor);
+		auto token = out++;
+		*token = static_cast<char>((std::min<std::size_t>(literals, 15) << 4) | std::min<std::size_t>(match - min_match, 15));
+		if (literals >= 15) {
+			out = internal::lz_length(out, literals - 15);
+		}
+		memcpy(out, anchor, literals);
+		out += literals;
+		const auto offset = static_cast<std::size_t>(ip - ref);
+		*out++ = static_cast<char>(offset);
+		*out++ = static_cast<char>(offset >> 8);
+		if (match - min_match >= 15) {
+			out = internal::lz_length(out, match - min_match - 15);
+		}
+		ip += match;
+		anchor = ip;
+	}
+	const auto literals = static_cast<std::size_t>(in + size - anchor);
+	*out++ = static_cast<char>(std::min<std::size_t>(literals, 15) << 4);
+	if (literals >= 15) {
+		out = internal::lz_length(out, literals - 15);
+	}
+	memcpy(out, anchor, literals);
+	out += literals;
+	return out - start;
+}
+
+bool lz_decompress(const char* in, std::size_t size, char* out, std::size_t raw) noexcept {
+	const auto in_end = in + size;
+	const auto out_start = out;
+	const auto out_end = out + raw;
+	auto length = [&in, in_end](std::size_t base, bool& ok) {
+		if (base != 15) {
+			return base;
+		}
+		unsigned char byte = 255;
+		while (byte == 255 && (ok = in != in_end)) {
+			byte = static_cast<unsigned char>(*in++);
+			base += byte;
+		}
+		return base;
+	};
+	while (in != in_end) {
+		const auto token = static_cast<unsigned char>(*in++);
+		bool ok = true;
+		const auto literals = length(token >> 4, ok);
+		if (!ok || static_cast<std::size_t>(in_end - in) < literals || static_cast<std::size_t>(out_end - out) < literals) {
+			return false;
+		}
+		memcpy(out, in, literals);
+		in += literals;
+		out += literals;
+		if (in == in_end) {
+			break;
+		}
+		if (in_end - in < 2) {
+			return false;
+		}
+		const auto offset = static_cast<std::size_t>(static_cast<unsigned char>(in[0]) | static_cast<unsigned char>(in[1]) << 8);
+		in += 2;
+		const auto match = length(token & 15, ok) + 4;
+		if (!ok || offset == 0 || offset > static_cast<std::size_t>(out - out_start) || static_cast<std::size_t>(out_end - out) < match) {
+			return false;
+		}
+		const char* ref = out - offset;
+		if (offset >= match) {
+			memcpy(out, ref, match);
+			out += match;
+		} else {
+			// Overlapping matches repeat the last 'offset' bytes. Copy runs from the match start, doubling as they land.
+			for (const auto end = out + match; out != end;) {
+				const auto n = std::min(static_cast<std::size_t>(out - ref), static_cast<std::size_t>(end - out));
+				memcpy(out, ref, n);
+				out += n;
+			}
+		}
+	}
+	return out == out_end;
+}
+
+constexpr std::size_t LzCompressor::max_block;
+constexpr unsigned LzCompressor::hash_bits;
+
+inline LzCompressor::LzCompressor(std::size_t block) :
+		m_block{std::max<std::size_t>(1, std::min(block, max_block))},
+		m_staged(m_block),
+		m_fill{},
+		m_frame(lz_header + lz_bound(m_block)),
+		m_frame_pos{},
+		m_table(1u << hash_bits),
+		m_base{} {
+	m_frame.resize(0);
+}
+
+inline std::size_t LzCompressor::compress(BIP<char>& in, BIP<char>& out, bool flush) {
+	std::size_t consumed = 0;
+	while (drain(out)) {
+		std::size_t size = 0;
+		const auto span = in.peek(size);
+		if (m_fill == 0 && size >= m_block) {
+			// Compress straight from the input partition.
+			frame(span, m_block, out);
+			in.skip(m_block);
+			consumed += m_block;
+			continue;
+		}
+		const auto read = in.get(m_staged.data() + m_fill, std::min(size, m_block - m_fill));
+		m_fill += read;
+		consumed += read;
+		if (m_fill == m_block || (flush && m_fill && in.empty())) {
+			frame(m_staged.data(), m_fill, out);
+			m_fill = 0;
+		} else if (read == 0) {
+			break;
+		}
+	}
+	return consumed;
+}
+
+bool LzCompressor::idle() const noexcept {
+	return m_fill == 0 && m_frame_pos == m_frame.size();
+}
+
+inline void LzCompressor::frame(const char* data, std::size_t size, BIP<char>& out) {
+	std::size_t free = 0;
+	auto direct = out.reserve(free);
+	const bool in_place = free >= lz_header + lz_bound(size);
+	if (!in_place) {
+		m_frame.resize(lz_header + lz_bound(size));
+		m_frame_pos = 0;
+		direct = m_frame.data();
+	}
+	auto payload = lz_compress(data, size, direct + lz_header, m_table.data(), m_base);
+	if (payload >= size) {
+		memcpy(direct + lz_header, data, size);
+		payload = size;
+	}
+	internal::lz_store32(direct, static_cast<std::uint32_t>(size));
+	internal::lz_store32(direct + 4, static_cast<std::uint32_t>(payload));
+	if (in_place) {
+		out.commit(lz_header + payload);
+	} else {
+		m_frame.resize(lz_header + payload);
+		drain(out);
+	}
+}
+
+inline bool LzCompressor::drain(BIP<char>& out) {
+	while (m_frame_pos != m_frame.size()) {
+		const auto written = out.put(m_frame.data() + m_frame_pos, m_frame.size() - m_frame_pos);
+		m_frame_pos += written;
+		if (written == 0 && out.full()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+inline LzDecompressor::LzDecompressor(std::size_t block) :
+		m_block{block},
+		m_frame(lz_header + lz_bound(block)),
+		m_fill{},
+		m_raw(block),
+		m_raw_pos{},
+		m_raw_size{},
+		m_failed{} {
+}
+
+inline std::size_t LzDecompressor::decompress(BIP<char>& in, BIP<char>& out) {
+	std::size_t produced = 0;
+	while (!m_failed && drain(out, produced)) {
+		std::size_t size = 0;
+		const auto span = in.peek(size);
+		const char* frame = nullptr;
+		if (m_fill == 0 && size >= lz_header) {
+			const auto payload = internal::lz_read32(span + 4);
+			if (size >= lz_header + payload) {
+				// Decompress straight from the input partition.
+				frame = span;
+			}
+		}
+		if (!frame) {
+			// Stage the header, then the payload.
+			auto needed = lz_header;
+			if (m_fill >= lz_header) {
+				const auto payload = internal::lz_read32(m_frame.data() + 4);
+				// Frames are never empty, and staging an empty payload would wait for it forever.
+				if (payload == 0 || payload > m_frame.size() - lz_header) {
+					m_failed = true;
+					break;
+				}
+				needed += payload;
+			}
+			const auto read = in.get(m_frame.data() + m_fill, std::min(size, needed - m_fill));
+			m_fill += read;
+			if (m_fill < needed || needed == lz_header) {
+				if (read == 0) {
+					break;
+				}
+				continue;
+			}
+			frame = m_frame.data();
+		}
+		const auto raw = internal::lz_read32(frame);
+		const auto payload = internal::lz_read32(frame + 4);
+		if (raw > m_block || payload == 0 || payload > lz_bound(raw)) {
+			m_failed = true;
+			break;
+		}
+		std::size_t free = 0;
+		auto direct = out.reserve(free);
+		const bool in_place = free >= raw;
+		if (!in_place) {
+			direct = m_raw.data();
+		}
+		if (payload == raw) {
+			memcpy(direct, frame + lz_header, raw);
+		} else if (!lz_decompress(frame + lz_header, payload, direct, raw)) {
+			m_failed = true;
+			break;
+		}
+		if (frame == m_frame.data()) {
+			m_fill = 0;
+		} else {
+			in.skip(lz_header + payload);
+		}
+		if (in_place) {
+			out.commit(raw);
+			produced += raw;
+		} else {
+			m_raw_pos = 0;
+			m_raw_size = raw;
+		}
+	}
+	return produced;
+}
+
+bool LzDecompressor::failed() const noexcept {
+	return m_failed;
+}
+
+inline bool LzDecompressor::drain(BIP<char>& out, std::size_t& produced) {
+	while (m_raw_pos != m_raw_size) {
+		const auto written = out.put(m_raw.data() + m_raw_pos, m_raw_size - m_raw_pos);
+		m_raw_pos += written;
+		produced += written;
+		if (written == 0 && out.full()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace bip
+
+#endif // BIP_LZ_H_INCLUDED
@@ -0,0 +1,244 @@
+/*
+ * Read-only consumer interface of a bi-partitioned circular buffer, served from a memory-mapped file.
+ */
+
+#ifndef BIP_MAPPED_H_INCLUDED
+#define BIP_MAPPED_H_INCLUDED
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace bip {
+
+/*
+ * The whole file is one readable region, so consumers written against BIP<T>'s get/peek/skip replay it without copies.
+ * Pages are read ahead in a sliding window in front of the reader and dropped from the mapping behind it
+ */
+template <typename T = char>
+class Mapped {
+public:
+    static constexpr std::size_t default_window = 4 * 1024 * 1024;
+
+    /*
+     * Map the file at 'path', reading 'window' bytes ahead. Throws std::system_error on failure
+     */
+    explicit Mapped(const char* path, std::size_t window = default_window);
+
+    /*
+     * Map the file referred to by 'fd', which stays open and owned by the caller
+     */
+    explicit Mapped(int fd, std::size_t window = default_window);
+
+    ~Mapped();
+
+    Mapped(const Mapped&) = delete;
+    Mapped& operator=(const Mapped&) = delete;
+
+    /*
+     * Attempt to read 'size' elements into 'data'. Returns the count of actual elements read
+     */
+    std::size_t get(T* data, std::size_t size) noexcept;
+
+    /*
+     * Attempt to skip 'size' elements. Returns the count of actual elements skipped
+     */
+    std::size_t skip(std::size_t size) noexcept;
+
+    /*
+     * Returns the rest of the file and stores its element count in 'size'. Consume it with skip()
+     */
+    inline const T* peek(std::size_t& size) const noexcept;
+
+    /*
+     * As BIP<T>::peek, with the rest of the file as the first region and no second one
+     */
+    inline std::size_t peek(const T*& first, std::size_t& first_size, const T*& second, std::size_t& second_size) const noexcept;
+
+    /*
+     * Returns how many elements are left to read
+     */
+    inline std::size_t avail() const noexcept;
+
+    /*
+     * Returns how many elements are left to read
+     */
+    inline std::size_t size() const noexcept;
+
+    /*
+     * Returns true if the whole file was consumed
+     */
+    inline bool empty() const noexcept;
+
+    /*
+     * Returns true if there are any elements to be read
+     */
+    inline bool have() const noexcept;
+
+private:
+    void map(int fd);
+
+    /*
+     * Slide the read ahead window after the reader moved
+     */
+    void advance() noexcept;
+
+    const std::size_t m_window;
+    const T* m_data;
+    std::size_t m_bytes;
+    std::size_t m_size;
+    std::size_t m_position;
+    std::size_t m_ahead;
+    std::size_t m_dropped;
+}; // class Mapped
+
+} // namespace bip
+
+namespace bip {
+
+template <typename T>
+constexpr std::size_t Mapped<T>::default_window;
+
+template <typename T>
+Mapped<T>::Mapped(const char* path, std::size_t window) :
+		m_window{window},
+		m_data{},
+		m_bytes{},
+		m_size{},
+		m_position{},
+		m_ahead{},
+		m_dropped{} {
+	const auto fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		throw std::system_error{errno, std::generic_category(), path};
+	}
+	try {
+		map(fd);
+	} catch (...) {
+		close(fd);
+		throw;
+	}
+	// The mapping keeps the file referenced.
+	close(fd);
+}
+
+template <typename T>
+Mapped<T>::Mapped(int fd, std::size_t window) :
+		m_window{window},
+		m_data{},
+		m_bytes{},
+		m_size{},
+		m_position{},
+		m_ahead{},
+		m_dropped{} {
+	map(fd);
+}
+
+template <typename T>
+Mapped<T>::~Mapped() {
+	if (m_data) {
+		munmap(const_cast<T*>(m_data), m_bytes);
+	}
+}
+
+template <typename T>
+std::size_t Mapped<T>::get(T* data, std::size_t size) noexcept {
+	const auto n = std::min(size, avail());
+	memcpy(data, m_data + m_position, n * sizeof(T));
+	return skip(n);
+}
+
+template <typename T>
+std::size_t Mapped<T>::skip(std::size_t size) noexcept {
+	const auto n = std::min(size, avail());
+	m_position += n;
+	advance();
+	return n;
+}
+
+template <typename T>
+const T* Mapped<T>::peek(std::size_t& size) const noexcept {
+	size = avail();
+	return m_data + m_position;
+}
+
+template <typename T>
+std::size_t Mapped<T>::peek(const T*& first, std::size_t& first_size, const T*& second, std::size_t& second_size) const noexcept {
+	first = peek(first_size);
+	second = m_data + m_size;
+	second_size = 0;
+	return first_size;
+}
+
+template <typename T>
+std::size_t Mapped<T>::avail() const noexcept {
+	return m_size - m_position;
+}
+
+template <typename T>
+std::size_t Mapped<T>::size() const noexcept {
+	return avail();
+}
+
+template <typename T>
+bool Mapped<T>::empty() const noexcept {
+	return avail() == 0;
+}
+
+template <typename T>
+bool Mapped<T>::have() const noexcept {
+	return !empty();
+}
+
+template <typename T>
+void Mapped<T>::map(int fd) {
+	struct stat st{};
+	if (fstat(fd, &st) != 0) {
+		throw std::system_error{errno, std::generic_category(), "fstat"};
+	}
+	m_bytes = static_cast<std::size_t>(st.st_size);
+	m_size = m_bytes / sizeof(T);
+	if (m_bytes == 0) {
+		return;
+	}
+	const auto memory = mmap(nullptr, m_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (memory == MAP_FAILED) {
+		throw std::system_error{errno, std::generic_category(), "mmap"};
+	}
+	m_data = static_cast<const T*>(memory);
+	madvise(memory, m_bytes, MADV_SEQUENTIAL);
+	advance();
+}
+
+template <typename T>
+void Mapped<T>::advance() noexcept {
+	if (!m_data) {
+		return;
+	}
+	const auto page = static_cast<std::size_t>(getpagesize());
+	const auto base = reinterpret_cast<std::uintptr_t>(m_data);
+	const auto position = m_position * sizeof(T);
+	// Request the next window once the reader is half way through the current one.
+	if (m_ahead < m_bytes && position + m_window / 2 >= m_ahead) {
+		const auto from = m_ahead / page * page;
+		m_ahead = std::min(m_bytes, position + m_window);
+		madvise(reinterpret_cast<void*>(base + from), m_ahead - from, MADV_WILLNEED);
+	}
+	// Unmap whole pages behind the reader a window at a time. They stay in the page cache.
+	const auto behind = position / page * page;
+	if (behind >= m_dropped + m_window) {
+		madvise(reinterpret_cast<void*>(base + m_dropped), behind - m_dropped, MADV_DONTNEED);
+		m_dropped = behind;
+	}
+}
+
+} // namespace bip
+
+#endif // BIP_MAPPED_H_INCLUDED
@@ -0,0 +1,71 @@
+/*
+ * User-level statically defined tracing (USDT) probes.
+ *
+ * Build with BIP_PROBES defined (make PROBES=1) to emit them. Each probe is then a single nop plus a .note.stapsdt entry,
+ * in the same format as <sys/sdt.h> without requiring it, so perf, bpftrace and SystemTap can attach to
+ * them at runtime, e.g.
+ *
+ *     bpftrace -e 'usdt:./app:bip:wait_enter { @[arg1] = count(); }'
+ *
+ * Without BIP_PROBES, or on other targets, the probe macros expand to nothing.
+ * Every argument is passed as a signed 64-bit value.
+ */
+
+#ifndef BIP_PROBE_H_INCLUDED
+#define BIP_PROBE_H_INCLUDED
+
+#if defined(BIP_PROBES) && defined(__GNUC__) && (defined(__x86_64__) || defined(__aarch64__))
+
+// The note refers to the nop through its address and to _.stapsdt.base for prelink adjustment.
+// "?" puts the note in the section group of the code, so that discarded template instances take it along.
+#define BIP_PROBE_NOTE(name, args) \
+	"990: nop\n" \
+	".pushsection .note.stapsdt,\"?\",\"note\"\n" \
+	".balign 4\n" \
+	".4byte 992f-991f, 994f-993f, 3\n" \
+	"991: .asciz \"stapsdt\"\n" \
+	"992: .balign 4\n" \
+	"993: .8byte 990b\n" \
+	".8byte _.stapsdt.base\n" \
+	".8byte 0\n" \
+	".asciz \"bip\"\n" \
+	".asciz \"" #name "\"\n" \
+	".asciz \"" args "\"\n" \
+	"994: .balign 4\n" \
+	".popsection\n" \
+	".ifndef _.stapsdt.base\n" \
+	".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+	".weak _.stapsdt.base\n" \
+	".hidden _.stapsdt.base\n" \
+	"_.stapsdt.base: .space 1\n" \
+	".size _.stapsdt.base, 1\n" \
+	".popsection\n" \
+	".endif\n"
+
+#define BIP_PROBE1(name, a) \
+	__asm__ __volatile__(BIP_PROBE_NOTE(name, "-8@%0") \
+		:: "nor"(static_cast<long long>(a)))
+
+#define BIP_PROBE2(name, a, b) \
+	__asm__ __volatile__(BIP_PROBE_NOTE(name, "-8@%0 -8@%1") \
+		:: "nor"(static_cast<long long>(a)), "nor"(static_cast<long long>(b)))
+
+#define BIP_PROBE3(name, a, b, c) \
+	__asm__ __volatile__(BIP_PROBE_NOTE(name, "-8@%0 -8@%1 -8@%2") \
+		:: "nor"(static_cast<long long>(a)), "nor"(static_cast<long long>(b)), "nor"(static_cast<long long>(c)))
+
+/*
+ * Returns a probe argument identifying buffer 'object'
+ */
+#define BIP_PROBE_ID(object) reinterpret_cast<long long>(object)
+
+#else
+
+#define BIP_PROBE1(name, a) do {} while (0)
+#define BIP_PROBE2(name, a, b) do {} while (0)
+#define BIP_PROBE3(name, a, b, c) do {} while (0)
+#define BIP_PROBE_ID(object) 0
+
+#endif
+
+#endif // BIP_PROBE_H_INCLUDED
@@ -0,0 +1,155 @@
+/*
+ * Token bucket rate limiting for bi-partitioned circular buffer consumers.
+ */
+
+#ifndef BIP_RATE_LIMIT_H_INCLUDED
+#define BIP_RATE_LIMIT_H_INCLUDED
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+
+#include "BipBlocking.h"
+
+namespace bip {
+
+class TokenBucket {
+public:
+    using clock = std::chrono::steady_clock;
+
+    /*
+     * Construct a full bucket refilled with 'rate' tokens per second, holding at most 'burst' tokens.
+     * Throws std::invalid_argument if 'rate' isn't positive or 'burst' is less than 1, as no request could ever be granted
+     */
+    TokenBucket(double rate, double burst);
+
+    /*
+     * Attempt to take 'size' tokens. Returns the count of actual tokens taken
+     */
+    inline std::size_t take(std::size_t size) noexcept;
+
+    /*
+     * Return 'size' unused tokens to the bucket
+     */
+    inline void give(std::size_t size) noexcept;
+
+    /*
+     * Returns the time at which 'size' tokens (at most 'burst') will be available
+     */
+    inline clock::time_point ready(std::size_t size) noexcept;
+
+private:
+    inline void refill(clock::time_point now) noexcept;
+
+    const double m_rate;
+    const double m_burst;
+    double m_tokens;
+    clock::time_point m_last;
+}; // class TokenBucket
+
+template <typename T>
+class RateLimited {
+public:
+    /*
+     * Throttle reads from 'blocking' to 'rate' elements per second with bursts of up to 'burst' (at least 1) elements.
+     * A throttled read waits until at least 'quantum' elements may be read. Throws std::invalid_argument on invalid limits
+     */
+    RateLimited(Blocking<T>& blocking, double rate, double burst, std::size_t quantum = 1);
+
+    RateLimited(const RateLimited&) = delete;
+    RateLimited& operator=(const RateLimited&) = delete;
+
+    /*
+     * Read up to 'size' elements into 'data', sleeping until tokens and data are available. Returns 0 only if closed and drained
+     */
+    std::size_t get(T* data, std::size_t size);
+
+    /*
+     * Attempt to read up to 'size' elements into 'data' without waiting. Returns the count of actual elements read
+     */
+    std::size_t try_get(T* data, std::size_t size);
+
+private:
+    Blocking<T>& m_blocking;
+    TokenBucket m_bucket;
+    const std::size_t m_quantum;
+}; // class RateLimited
+
+} // namespace bip
+
+namespace bip {
+
+inline TokenBucket::TokenBucket(double rate, double burst) :
+		m_rate{rate},
+		m_burst{burst},
+		m_tokens{burst},
+		m_last{clock::now()} {
+	if (!(rate > 0) || !(burst >= 1)) {
+		throw std::invalid_argument{"Token bucket rate or burst"};
+	}
+}
+
+std::size_t TokenBucket::take(std::size_t size) noexcept {
+	refill(clock::now());
+	// Compared as doubles first, as a burst may hold more tokens than a std::size_t counts.
+	const auto taken = m_tokens < static_cast<double>(size) ? static_cast<std::size_t>(m_tokens) : size;
+	m_tokens -= taken;
+	return taken;
+}
+
+void TokenBucket::give(std::size_t size) noexcept {
+	m_tokens = std::min(m_burst, m_tokens + size);
+}
+
+TokenBucket::clock::time_point TokenBucket::ready(std::size_t size) noexcept {
+	const auto now = clock::now();
+	refill(now);
+	const auto missing = std::min(static_cast<double>(size), m_burst) - m_tokens;
+	if (missing <= 0) {
+		return now;
+	}
+	const std::chrono::duration<double> wait{missing / m_rate};
+	return now + std::chrono::duration_cast<clock::duration>(wait) + clock::duration{1};
+}
+
+void TokenBucket::refill(clock::time_point now) noexcept {
+	const std::chrono::duration<double> elapsed = now - m_last;
+	m_tokens = std::min(m_burst, m_tokens + elapsed.count() * m_rate);
+	m_last = now;
+}
+
+template <typename T>
+RateLimited<T>::RateLimited(Blocking<T>& blocking, double rate, double burst, std::size_t quantum) :
+		m_blocking(blocking),
+		m_bucket{rate, burst},
+		m_quantum{burst < static_cast<double>(quantum) ? static_cast<std::size_t>(burst) : std::max<std::size_t>(quantum, 1)} {
+}
+
+template <typename T>
+std::size_t RateLimited<T>::get(T* data, std::size_t size) {
+	if (size == 0) {
+		return 0;
+	}
+	std::size_t granted = 0;
+	while ((granted = m_bucket.take(size)) < std::min(size, m_quantum)) {
+		m_bucket.give(granted);
+		std::this_thread::sleep_until(m_bucket.ready(std::min(size, m_quantum)));
+	}
+	const auto read = m_blocking.get(data, granted);
+	m_bucket.give(granted - read);
+	return read;
+}
+
+template <typename T>
+std::size_t RateLimited<T>::try_get(T* data, std::size_t size) {
+	const auto granted = m_bucket.take(size);
+	const auto read = m_blocking.try_get(data, granted);
+	m_bucket.give(granted - read);
+	return read;
+}
+
+} // namespace bip
+
+#endif // BIP_RATE_LIMIT_H_INCLUDED
@@ -0,0 +1,301 @@
+/*
+ * Real-time safe bi-partitioned circular buffer: locked, prefaulted memory and wait-free access.
+ */
+
+#ifndef BIP_REALTIME_H_INCLUDED
+#define BIP_REALTIME_H_INCLUDED
+
+#include <cerrno>
+#include <cstdint>
+#include <new>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "BipSpsc.h"
+
+namespace bip {
+
+template <typename T>
+class Realtime {
+public:
+    class Producer;
+    class Consumer;
+
+    /*
+     * Allocate storage for 'size' elements together with the cursors, fault it in and lock it in memory.
+     * Throws std::bad_alloc if allocation fails, and std::system_error if locking fails and 'strict' is set
+     */
+    explicit Realtime(std::size_t size, bool strict = true);
+
+    ~Realtime();
+
+    Realtime(const Realtime&) = delete;
+    Realtime& operator=(const Realtime&) = delete;
+
+    /*
+     * Returns the handle for the producer thread
+     */
+    inline Producer producer() noexcept;
+
+    /*
+     * Returns the handle for the consumer thread
+     */
+    inline Consumer consumer() noexcept;
+
+    /*
+     * Returns true if the memory is locked
+     */
+    inline bool locked() const noexcept;
+
+private:
+    static constexpr std::size_t header = (sizeof(SPSC<T>) + alignof(T) - 1) / alignof(T) * alignof(T);
+
+    void* m_memory;
+    std::size_t m_bytes;
+    SPSC<T>* m_spsc;
+    bool m_locked;
+}; // class Realtime
+
+/*
+ * Real-time thread access to the producer side. Every method is wait-free and never allocates or enters the kernel
+ */
+template <typename T>
+class Realtime<T>::Producer {
+public:
+    using realtime_safe = std::true_type;
+
+    /*
+     * Attempt to write 'size' elements from 'data'. Returns the count of actual elements written
+     */
+    inline std::size_t put(const T* data, std::size_t size) noexcept;
+
+    /*
+     * Returns the contiguous region available for writing and stores its element count in 'size'
+     */
+    inline T* reserve(std::size_t& size) noexcept;
+
+    /*
+     * Publish 'size' elements of the reserved region. Returns the count of actual elements committed
+     */
+    inline std::size_t commit(std::size_t size) noexcept;
+
+    /*
+     * Returns how many elements can be written in a single write
+     */
+    inline std::size_t free() noexcept;
+
+private:
+    friend class Realtime;
+
+    inline explicit Producer(SPSC<T>* spsc) noexcept;
+
+    SPSC<T>* m_spsc;
+}; // class Realtime<T>::Producer
+
+/*
+ * Real-time thread access to the consumer side. Every method is wait-free and never allocates or enters the kernel
+ */
+template <typename T>
+class Realtime<T>::Consumer {
+public:
+    using realtime_safe = std::true_type;
+
+    /*
+     * Attempt to read 'size' elements into 'data'. Returns the count of actual elements read
+     */
+    inline std::size_t get(T* data, std::size_t size) noexcept;
+
+    /*
+     * Returns the contiguous region available for reading and stores its element count in 'size'
+     */
+    inline const T* peek(std::size_t& size) noexcept;
+
+    /*
+     * Attempt to skip 'size' elements. Returns the count of actual elements skipped
+     */
+    inline std::size_t skip(std::size_t size) noexcept;
+
+    /*
+     * Returns how many elements are available for a single read
+     */
+    inline std::size_t avail() noexcept;
+
+    /*
+     * Returns true if there are no elements available for read
+     */
+    inline bool empty() noexcept;
+
+private:
+    friend class Realtime;
+
+    inline explicit Consumer(SPSC<T>* spsc) noexcept;
+
+    SPSC<T>* m_spsc;
+}; // class Realtime<T>::Consumer
+
+/*
+ * Returns true for real-time producer and consumer handles
+ */
+template <typename Handle>
+struct is_realtime_safe {
+private:
+    template <typename U>
+    static typename U::realtime_safe check(int);
+    template <typename U>
+    static std::false_type check(...);
+public:
+    static constexpr bool value = decltype(check<Handle>(0))::value;
+}; // struct is_realtime_safe
+
+/*
+ * Start a real-time thread running 'body' with 'handles'. Fails to compile unless 'body' is captureless and noexcept
+ * and every handle is a real-time one, so that no buffer state reaches the thread except through those handles.
+ * The compiler can't see what else 'body' calls: keeping it off globals, locks, allocation and system calls is up to it
+ */
+template <typename F, typename... Handles>
+std::thread realtime_thread(F body, Handles... handles);
+
+} // namespace bip
+
+namespace bip {
+
+template <typename T>
+constexpr std::size_t Realtime<T>::header;
+
+template <typename T>
+Realtime<T>::Realtime(std::size_t size, bool strict) :
+		m_memory{},
+		m_bytes{header + size * sizeof(T)},
+		m_spsc{},
+		m_locked{} {
+	static_assert(std::is_trivially_copyable<T>::value, "Elements are copied with memcpy");
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_POPULATE
+	flags |= MAP_POPULATE;
+#endif
+	m_memory = mmap(nullptr, m_bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+	if (m_memory == MAP_FAILED) {
+		m_memory = nullptr;
+		throw std::bad_alloc{};
+	}
+	// Write every page so that none is left copy-on-write of the zero page.
+	const auto page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+	for (std::size_t offset = 0; offset < m_bytes; offset += page) {
+		static_cast<volatile char*>(m_memory)[offset] = 0;
+	}
+	m_locked = mlock(m_memory, m_bytes) == 0;
+	if (!m_locked && strict) {
+		const auto error = errno;
+		munmap(m_memory, m_bytes);
+		throw std::system_error{error, std::generic_category(), "mlock"};
+	}
+	auto storage = reinterpret_cast<T*>(static_cast<unsigned char*>(m_memory) + header);
+	m_spsc = new (m_memory) SPSC<T>{storage, size};
+}
+
+template <typename T>
+Realtime<T>::~Realtime() {
+	m_spsc->~SPSC();
+	if (m_locked) {
+		munlock(m_memory, m_bytes);
+	}
+	munmap(m_memory, m_bytes);
+}
+
+template <typename T>
+auto Realtime<T>::producer() noexcept -> Producer {
+	return Producer{m_spsc};
+}
+
+template <typename T>
+auto Realtime<T>::consumer() noexcept -> Consumer {
+	return Consumer{m_spsc};
+}
+
+template <typename T>
+bool Realtime<T>::locked() const noexcept {
+	return m_locked;
+}
+
+template <typename T>
+Realtime<T>::Producer::Producer(SPSC<T>* spsc) noexcept :
+		m_spsc{spsc} {
+}
+
+template <typename T>
+std::size_t Realtime<T>::Producer::put(const T* data, std::size_t size) noexcept {
+	return m_spsc->put(data, size);
+}
+
+template <typename T>
+T* Realtime<T>::Producer::reserve(std::size_t& size) noexcept {
+	return m_spsc->reserve(size);
+}
+
+template <typename T>
+std::size_t Realtime<T>::Producer::commit(std::size_t size) noexcept {
+	return m_spsc->commit(size);
+}
+
+template <typename T>
+std::size_t Realtime<T>::Producer::free() noexcept {
+	return m_spsc->free();
+}
+
+template <typename T>
+Realtime<T>::Consumer::Consumer(SPSC<T>* spsc) noexcept :
+		m_spsc{spsc} {
+}
+
+template <typename T>
+std::size_t Realtime<T>::Consumer::get(T* data, std::size_t size) noexcept {
+	return m_spsc->get(data, size);
+}
+
+template <typename T>
+const T* Realtime<T>::Consumer::peek(std::size_t& size) noexcept {
+	return m_spsc->peek(size);
+}
+
+template <typename T>
+std::size_t Realtime<T>::Consumer::skip(std::size_t size) noexcept {
+	return m_spsc->skip(size);
+}
+
+template <typename T>
+std::size_t Realtime<T>::Consumer::avail() noexcept {
+	return m_spsc->avail();
+}
+
+template <typename T>
+bool Realtime<T>::Consumer::empty() noexcept {
+	return m_spsc->empty();
+}
+
+namespace internal {
+
+template <typename... Handles>
+struct all_realtime_safe : std::true_type {};
+
+template <typename Handle, typename... Handles>
+struct all_realtime_safe<Handle, Handles...> :
+		std::integral_constant<bool, is_realtime_safe<Handle>::value && all_realtime_safe<Handles...>::value> {};
+
+} // namespace internal
+
+template <typename F, typename... Handles>
+std::thread realtime_thread(F body, Handles... handles) {
+	static_assert(internal::all_realtime_safe<Handles...>::value, "Real-time threads may only use Realtime producer and consumer handles");
+	static_assert(std::is_empty<F>::value, "Real-time thread bodies may not capture state");
+	static_assert(noexcept(body(handles...)), "Real-time thread bodies must be noexcept");
+	return std::thread{body, handles...};
+}
+
+} // namespace bip
+
+#endif // BIP_REALTIME_H_INCLUDED
@@ -0,0 +1,24 @@
+/*
+ * Spin-wait hint for the waiting wrappers of bi-partitioned circular buffers.
+ */
+
+#ifndef BIP_RELAX_H_INCLUDED
+#define BIP_RELAX_H_INCLUDED
+
+namespace bip {
+
+/*
+ * Tell the core this is a spin loop, which frees pipeline resources for an SMT sibling, without giving up the core
+ * or entering the kernel. Does nothing on targets without such a hint
+ */
+inline void relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+	asm volatile("yield");
+#endif
+}
+
+} // namespace bip
+
+#endif // BIP_RELAX_H_INCLUDED
@@ -0,0 +1,310 @@
+/*
+ * Bi-partitioned circular buffer over reserved address space, committing pages as they are first written.
+ */
+
+#ifndef BIP_RESERVED_H_INCLUDED
+#define BIP_RESERVED_H_INCLUDED
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "Bip.h"
+
+namespace bip {
+
+/*
+ * Storage is reserved with PROT_NONE for the maximum size up front and made writable in granules just ahead of
+ * the Put partition's end, so an idle ring costs a few pages. Writes go through this class, never through a
+ * BIP<T>& to the underlying buffer, which could reach pages not committed yet
+ */
+template <typename T>
+class Reserved {
+public:
+    static constexpr std::size_t default_granule = 64 * 1024;
+
+    /*
+     * Reserve address space for 'size' elements, committing 'granule' bytes at a time.
+     * Throws std::bad_alloc if the reservation fails
+     */
+    explicit Reserved(std::size_t size, std::size_t granule = default_granule);
+
+    ~Reserved();
+
+    Reserved(const Reserved&) = delete;
+    Reserved& operator=(const Reserved&) = delete;
+
+    /*
+     * Attempt to write 'size' elements from 'data'. Returns the count of actual elements written,
+     * which falls short if committing more memory fails
+     */
+    std::size_t put(const T* data, std::size_t size) noexcept;
+
+    /*
+     * Returns the contiguous region available for writing, up to the committed pages, and stores its element count in 'size'.
+     * Pages are committed first for up to 'want' elements of the region, or as many as the kernel allows
+     */
+    T* reserve(std::size_t& size, std::size_t want = 1) noexcept;
+
+    /*
+     * Mark 'size' elements of the reserved region as written. Returns the count of actual elements committed
+     */
+    inline std::size_t commit(std::size_t size) noexcept;
+
+    /*
+     * Attempt to read 'size' elements into 'data'. Returns the count of actual elements read
+     */
+    inline std::size_t get(T* data, std::size_t size) noexcept;
+
+    /*
+     * Attempt to skip 'size' elements. Returns the count of actual elements skipped
+     */
+    inline std::size_t skip(std::size_t size) noexcept;
+
+    /*
+     * Returns the contiguous region available for reading and stores its element count in 'size'.
+     * Consume it with skip()
+     */
+    inline const T* peek(std::size_t& size) const noexcept;
+
+    /*
+     * Returns how many elements are available for a single read
+     */
+    inline std::size_t avail() const noexcept;
+
+    /*
+     * Returns how many elements can be written in a single write, counting pages not committed yet
+     */
+    inline std::size_t free() const noexcept;
+
+    /*
+     * Returns how many elements can be written in total, across a partition switch
+     */
+    inline std::size_t space() const noexcept;
+
+    /*
+     * Returns how many elements are available in total, across a partition switch
+     */
+    inline std::size_t size() const noexcept;
+
+    /*
+     * Returns true if there are no elements available for read
+     */
+    inline bool empty() const noexcept;
+
+    /*
+     * Returns true if the buffer can't accept more elements
+     */
+    inline bool full() const noexcept;
+
+    /*
+     * Returns true if there are any elements to be read
+     */
+    inline bool have() const noexcept;
+
+    /*
+     * Give back the physical pages not holding data. They stay committed and read as zero when written again
+     */
+    void trim() noexcept;
+
+    /*
+     * Returns the byte count of address space made writable so far
+     */
+    inline std::size_t committed() const noexcept;
+
+private:
+    static inline T* map(std::size_t bytes);
+
+    /*
+     * Make the storage up to 'end' writable. Returns false if the kernel refuses
+     */
+    bool ensure(const T* end) noexcept;
+
+    void release(const void* begin, const void* end) noexcept;
+
+    const std::size_t m_bytes;
+    const std::size_t m_granule;
+    T* const m_base;
+    unsigned char* m_committed;
+    BIP<T> m_bip;
+}; // class Reserved
+
+} // namespace bip
+
+namespace bip {
+
+template <typename T>
+constexpr std::size_t Reserved<T>::default_granule;
+
+template <typename T>
+Reserved<T>::Reserved(std::size_t size, std::size_t granule) :
+		m_bytes{std::max<std::size_t>(size * sizeof(T), 1)},
+		m_granule{std::max<std::size_t>((granule + getpagesize() - 1) / getpagesize() * getpagesize(), getpagesize())},
+		m_base{map(m_bytes)},
+		m_committed{reinterpret_cast<unsigned char*>(m_base)},
+		m_bip{m_base, size} {
+}
+
+template <typename T>
+Reserved<T>::~Reserved() {
+	munmap(m_base, m_bytes);
+}
+
+template <typename T>
+std::size_t Reserved<T>::put(const T* data, std::size_t size) noexcept {
+	std::size_t f = 0;
+	const auto out = reserve(f, size);
+	const auto n = std::min(size, f);
+	memcpy(out, data, n * sizeof(T));
+	return commit(n);
+}
+
+template <typename T>
+T* Reserved<T>::reserve(std::size_t& size, std::size_t want) noexcept {
+	const auto out = m_bip.reserve(size);
+	// Short of all the pages wanted, settle for the granule of the next element.
+	if (size != 0 && !ensure(out + std::min(size, std::max<std::size_t>(want, 1))) && !ensure(out + 1)) {
+		size = 0;
+		return out;
+	}
+	const auto committed = static_cast<std::size_t>(m_committed - reinterpret_cast<unsigned char*>(out)) / sizeof(T);
+	size = std::min(size, committed);
+	return out;
+}
+
+template <typename T>
+std::size_t Reserved<T>::commit(std::size_t size) noexcept {
+	return m_bip.commit(size);
+}
+
+template <typename T>
+std::size_t Reserved<T>::get(T* data, std::size_t size) noexcept {
+	return m_bip.get(data, size);
+}
+
+template <typename T>
+std::size_t Reserved<T>::skip(std::size_t size) noexcept {
+	return m_bip.skip(size);
+}
+
+template <typename T>
+const T* Reserved<T>::peek(std::size_t& size) const noexcept {
+	return m_bip.peek(size);
+}
+
+template <typename T>
+std::size_t Reserved<T>::avail() const noexcept {
+	return m_bip.avail();
+}
+
+template <typename T>
+std::size_t Reserved<T>::free() const noexcept {
+	return m_bip.free();
+}
+
+template <typename T>
+std::size_t Reserved<T>::space() const noexcept {
+	return m_bip.space();
+}
+
+template <typename T>
+std::size_t Reserved<T>::size() const noexcept {
+	return m_bip.size();
+}
+
+template <typename T>
+bool Reserved<T>::empty() const noexcept {
+	return m_bip.empty();
+}
+
+template <typename T>
+bool Reserved<T>::full() const noexcept {
+	return m_bip.full();
+}
+
+template <typename T>
+bool Reserved<T>::have() const noexcept {
+	return m_bip.have();
+}
+
+template <typename T>
+void Reserved<T>::trim() noexcept {
+	const T* first = nullptr;
+	const T* second = nullptr;
+	std::size_t first_size = 0;
+	std::size_t second_size = 0;
+	m_bip.peek(first, first_size, second, second_size);
+	// Live data lies in at most two ranges, each inside the committed part.
+	const auto base = reinterpret_cast<const unsigned char*>(m_base);
+	const unsigned char* live[4] = {base, base, base, base};
+	std::size_t ranges = 0;
+	if (first_size) {
+		live[ranges++] = reinterpret_cast<const unsigned char*>(first);
+		live[ranges++] = reinterpret_cast<const unsigned char*>(first + first_size);
+	}
+	if (second_size) {
+		live[ranges++] = reinterpret_cast<const unsigned char*>(second);
+		live[ranges++] = reinterpret_cast<const unsigned char*>(second + second_size);
+	}
+	if (ranges == 4 && live[2] < live[0]) {
+		std::swap(live[0], live[2]);
+		std::swap(live[1], live[3]);
+	}
+	auto gap = base;
+	for (std::size_t i = 0; i < ranges; i += 2) {
+		release(gap, live[i]);
+		gap = live[i + 1];
+	}
+	release(gap, m_committed);
+}
+
+template <typename T>
+std::size_t Reserved<T>::committed() const noexcept {
+	return static_cast<std::size_t>(m_committed - reinterpret_cast<unsigned char*>(m_base));
+}
+
+template <typename T>
+T* Reserved<T>::map(std::size_t bytes) {
+	const auto memory = mmap(nullptr, bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (memory == MAP_FAILED) {
+		throw std::bad_alloc{};
+	}
+	return static_cast<T*>(memory);
+}
+
+template <typename T>
+bool Reserved<T>::ensure(const T* end) noexcept {
+	const auto need = reinterpret_cast<const unsigned char*>(end);
+	if (need <= m_committed) {
+		return true;
+	}
+	// Whole granules, which are whole pages, but not past the reservation.
+	const auto base = reinterpret_cast<unsigned char*>(m_base);
+	const auto page = static_cast<std::size_t>(getpagesize());
+	const auto offset = static_cast<std::size_t>(need - base);
+	const auto target = base + std::min((offset + m_granule - 1) / m_granule * m_granule, (m_bytes + page - 1) / page * page);
+	if (mprotect(m_committed, static_cast<std::size_t>(target - m_committed), PROT_READ | PROT_WRITE) != 0) {
+		return false;
+	}
+	m_committed = target;
+	return true;
+}
+
+template <typename T>
+void Reserved<T>::release(const void* begin, const void* end) noexcept {
+	// Whole pages only, since the others share bytes with live data.
+	const auto page = static_cast<std::uintptr_t>(getpagesize());
+	const auto from = (reinterpret_cast<std::uintptr_t>(begin) + page - 1) / page * page;
+	const auto to = reinterpret_cast<std::uintptr_t>(end) / page * page;
+	if (from < to) {
+		madvise(reinterpret_cast<void*>(from), to - from, MADV_DONTNEED);
+	}
+}
+
+} // namespace bip
+
+#endif // BIP_RESERVED_H_INCLUDED
@@ -0,0 +1,274 @@
+/*
+ * Bi-partitioned circular buffer in memory shared between processes, with futex based waiting.
+ */
+
+#ifndef BIP_SHARED_H_INCLUDED
+#define BIP_SHARED_H_INCLUDED
+
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <new>
+#include <system_error>
+#include <type_traits>
+
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "BipRelax.h"
+#include "BipSpsc.h"
+
+namespace bip {
+
+namespace internal {
+
+/*
+ * Wait queue keyed by a futex word. Wakers only enter the kernel while somebody sleeps
+ */
+struct Event {
+    std::atomic<std::uint32_t> seq;
+    std::atomic<std::uint32_t> waiters;
+}; // struct Event
+
+struct SharedHeader {
+    static constexpr std::uint32_t signature = 0x42495053; // "BIPS"
+
+    std::uint32_t magic;
+    std::uint32_t element;
+    std::uint64_t size;
+    std::atomic<std::uint32_t> closed;
+    Cursors cursors;
+    alignas(Cursors::cache_line) Event readable;
+    alignas(Cursors::cache_line) Event writable;
+}; // struct SharedHeader
+
+} // namespace internal
+
+template <typename T>
+class Shared {
+public:
+    /*
+     * Create a buffer of 'size' elements (at least 2) in the file referred to by 'fd', resizing it to fit.
+     * Waits spin 'spin' times on a pause instruction before sleeping. Throws std::system_error on failure
+     */
+    Shared(int fd, std::size_t size, unsigned spin = 64);
+
+    /*
+     * Attach to the buffer created in the file referred to by 'fd'. Throws std::system_error on failure
+     */
+    explicit Shared(int fd, unsigned spin = 64);
+
+    ~Shared();
+
+    Shared(const Shared&) = delete;
+    Shared& operator=(const Shared&) = delete;
+
+    /*
+     * Producer: write 'size' elements from 'data', waiting for free space as needed. Returns less than 'size' only if closed
+     */
+    std::size_t put(const T* data, std::size_t size);
+
+    /*
+     * Consumer: read up to 'size' elements into 'data', waiting until at least one is available.
+     * Returns 0 only if closed and drained
+     */
+    std::size_t get(T* data, std::size_t size);
+
+    /*
+     * Wake all waiters in both processes. Subsequent puts fail, gets drain what is left
+     */
+    void close();
+
+    /*
+     * Returns the underlying non-blocking buffer. Wake the other side with notify_readable() or notify_writable()
+     */
+    inline SPSC<T>& ring() noexcept;
+
+    /*
+     * Producer: wake a consumer sleeping in get()
+     */
+    inline void notify_readable() noexcept;
+
+    /*
+     * Consumer: wake a producer sleeping in put()
+     */
+    inline void notify_writable() noexcept;
+
+private:
+    static constexpr std::size_t header = (sizeof(internal::SharedHeader) + alignof(T) - 1) / alignof(T) * alignof(T);
+
+    void map(int fd, std::size_t bytes);
+
+    template <typename P>
+    void wait(internal::Event& event, P ready);
+
+    static inline void wake(internal::Event& event) noexcept;
+
+    const unsigned m_spin;
+    void* m_memory;
+    std::size_t m_bytes;
+    internal::SharedHeader* m_header;
+    typename std::aligned_storage<sizeof(SPSC<T>), alignof(SPSC<T>)>::type m_storage;
+    SPSC<T>* m_ring;
+}; // class Shared
+
+} // namespace bip
+
+namespace bip {
+
+template <typename T>
+constexpr std::size_t Shared<T>::header;
+
+template <typename T>
+Shared<T>::Shared(int fd, std::size_t size, unsigned spin) :
+		m_spin{spin},
+		m_memory{},
+		m_bytes{},
+		m_header{},
+		m_storage{},
+		m_ring{} {
+	static_assert(std::is_trivially_copyable<T>::value, "Elements are copied with memcpy");
+	const auto bytes = header + size * sizeof(T);
+	if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+		throw std::system_error{errno, std::generic_category(), "ftruncate"};
+	}
+	map(fd, bytes);
+	m_header = new (m_memory) internal::SharedHeader{};
+	m_header->element = sizeof(T);
+	m_header->size = size;
+	m_header->closed.store(0, std::memory_order_relaxed);
+	m_header->cursors.write.store(0, std::memory_order_relaxed);
+	m_header->cursors.last.store(0, std::memory_order_relaxed);
+	m_header->cursors.read.store(0, std::memory_order_relaxed);
+	for (auto event : {&m_header->readable, &m_header->writable}) {
+		event->seq.store(0, std::memory_order_relaxed);
+		event->waiters.store(0, std::memory_order_relaxed);
+	}
+	__atomic_store_n(&m_header->magic, internal::SharedHeader::signature, __ATOMIC_RELEASE);
+	m_ring = new (&m_storage) SPSC<T>{reinterpret_cast<T*>(static_cast<unsigned char*>(m_memory) + header), size, m_header->cursors};
+}
+
+template <typename T>
+Shared<T>::Shared(int fd, unsigned spin) :
+		m_spin{spin},
+		m_memory{},
+		m_bytes{},
+		m_header{},
+		m_storage{},
+		m_ring{} {
+	struct stat st{};
+	if (fstat(fd, &st) != 0) {
+		throw std::system_error{errno, std::generic_category(), "fstat"};
+	}
+	map(fd, static_cast<std::size_t>(st.st_size));
+	m_header = static_cast<internal::SharedHeader*>(m_memory);
+	if (m_bytes < header || __atomic_load_n(&m_header->magic, __ATOMIC_ACQUIRE) != internal::SharedHeader::signature ||
+			m_header->element != sizeof(T) || header + m_header->size * sizeof(T) > m_bytes) {
+		munmap(m_memory, m_bytes);
+		throw std::system_error{EINVAL, std::generic_category(), "Not a shared BIP buffer"};
+	}
+	m_ring = new (&m_storage) SPSC<T>{reinterpret_cast<T*>(static_cast<unsigned char*>(m_memory) + header), m_header->size, m_header->cursors};
+}
+
+template <typename T>
+Shared<T>::~Shared() {
+	m_ring->~SPSC();
+	munmap(m_memory, m_bytes);
+}
+
+template <typename T>
+std::size_t Shared<T>::put(const T* data, std::size_t size) {
+	std::size_t written = 0;
+	while (written < size) {
+		wait(m_header->writable, [this]() {
+			return m_header->closed.load(std::memory_order_acquire) || m_ring->free() != 0;
+		});
+		if (m_header->closed.load(std::memory_order_acquire)) {
+			break;
+		}
+		written += m_ring->put(data + written, size - written);
+		notify_readable();
+	}
+	return written;
+}
+
+template <typename T>
+std::size_t Shared<T>::get(T* data, std::size_t size) {
+	if (size == 0) {
+		return 0;
+	}
+	wait(m_header->readable, [this]() {
+		return m_ring->have() || m_header->closed.load(std::memory_order_acquire);
+	});
+	const auto read = m_ring->get(data, size);
+	notify_writable();
+	return read;
+}
+
+template <typename T>
+void Shared<T>::close() {
+	m_header->closed.store(1, std::memory_order_release);
+	notify_readable();
+	notify_writable();
+}
+
+template <typename T>
+SPSC<T>& Shared<T>::ring() noexcept {
+	return *m_ring;
+}
+
+template <typename T>
+void Shared<T>::notify_readable() noexcept {
+	wake(m_header->readable);
+}
+
+template <typename T>
+void Shared<T>::notify_writable() noexcept {
+	wake(m_header->writable);
+}
+
+template <typename T>
+void Shared<T>::map(int fd, std::size_t bytes) {
+	m_memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (m_memory == MAP_FAILED) {
+		m_memory = nullptr;
+		throw std::system_error{errno, std::generic_category(), "mmap"};
+	}
+	m_bytes = bytes;
+}
+
+template <typename T>
+template <typename P>
+void Shared<T>::wait(internal::Event& event, P ready) {
+	// Spinning stays in user space, so a busy channel makes no system calls.
+	for (unsigned i = 0; i < m_spin && !ready(); ++i) {
+		relax();
+	}
+	while (!ready()) {
+		event.waiters.fetch_add(1, std::memory_order_seq_cst);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const auto seq = event.seq.load(std::memory_order_seq_cst);
+		if (!ready()) {
+			// Process shared: no FUTEX_PRIVATE_FLAG.
+			syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&event.seq), FUTEX_WAIT, seq, nullptr, nullptr, 0);
+		}
+		event.waiters.fetch_sub(1, std::memory_order_seq_cst);
+	}
+}
+
+template <typename T>
+void Shared<T>::wake(internal::Event& event) noexcept {
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (event.waiters.load(std::memory_order_seq_cst)) {
+		event.seq.fetch_add(1, std::memory_order_seq_cst);
+		syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&event.seq), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+	}
+}
+
+} // namespace bip
+
+#endif // BIP_SHARED_H_INCLUDED
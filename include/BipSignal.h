@@ -0,0 +1,198 @@
+/*
+ * Async-signal-safe record producer over a bi-partitioned circular buffer.
+ */
+
+#ifndef BIP_SIGNAL_H_INCLUDED
+#define BIP_SIGNAL_H_INCLUDED
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+namespace bip {
+
+/*
+ * Variable length records, each either fully before the end of the buffer or after a padding record wrapping to its start.
+ *
+ * The producer methods are async-signal-safe: they are lock-free, never allocate, make no system calls and leave
+ * errno alone. Any number of threads and signal handlers may produce, including a handler interrupting a put on
+ * the same buffer. Records are read in reservation order by one normal thread.
+ */
+class SignalRing {
+public:
+    static constexpr std::size_t align = 8;
+
+    /*
+     * Construct a ring at memory block 'buf' of 'size' bytes, which must be 8-byte aligned
+     */
+    SignalRing(void* buf, std::size_t size) noexcept;
+
+    SignalRing(const SignalRing&) = delete;
+    SignalRing& operator=(const SignalRing&) = delete;
+
+    /*
+     * Producer: attempt to write a record of 'size' bytes from 'data'. Returns false if it doesn't fit
+     */
+    inline bool put(const void* data, std::size_t size) noexcept;
+
+    /*
+     * Producer: reserve a record of 'size' bytes. Returns nullptr if it doesn't fit. Fill it then publish() it
+     */
+    inline void* reserve(std::size_t size) noexcept;
+
+    /*
+     * Producer: make record 'record' obtained from reserve() readable
+     */
+    inline void publish(void* record) noexcept;
+
+    /*
+     * Producer: returns how many records didn't fit
+     */
+    inline std::uint64_t dropped() const noexcept;
+
+    /*
+     * Consumer: returns the next record and stores its byte count in 'size', or returns nullptr if it isn't published yet
+     */
+    inline const void* peek(std::size_t& size) noexcept;
+
+    /*
+     * Consumer: release the record returned by peek()
+     */
+    inline void skip() noexcept;
+
+    /*
+     * Consumer: attempt to read the next record into 'data' of 'size' bytes, truncating it if needed.
+     * Returns the record byte count, or 0 if there is none
+     */
+    inline std::size_t get(void* data, std::size_t size) noexcept;
+
+private:
+    enum : std::uint32_t {
+        Empty = 0,
+        Ready = 1,
+        Padding = 2,
+    };
+
+    struct Header {
+        std::uint32_t size;
+        std::uint32_t state;
+    };
+
+    static constexpr std::size_t round(std::size_t size) noexcept {
+        return (size + align - 1) / align * align;
+    }
+
+    inline Header* header(std::uint64_t position) const noexcept;
+    inline void release(std::uint64_t position, std::size_t bytes) noexcept;
+
+    unsigned char* const m_buf;
+    const std::size_t m_size;
+    alignas(64) std::atomic<std::uint64_t> m_head;
+    std::atomic<std::uint64_t> m_dropped;
+    alignas(64) std::atomic<std::uint64_t> m_tail;
+}; // class SignalRing
+
+} // namespace bip
+
+namespace bip {
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "Signal handlers need lock-free 64-bit atomics");
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "Signal handlers need lock-free 32-bit atomics");
+
+inline SignalRing::SignalRing(void* buf, std::size_t size) noexcept :
+		m_buf{static_cast<unsigned char*>(buf)},
+		m_size{size / align * align},
+		m_head{0},
+		m_dropped{0},
+		m_tail{0} {
+	// Headers are recognized by their state, so stale bytes must read as Empty.
+	memset(m_buf, 0, m_size);
+}
+
+bool SignalRing::put(const void* data, std::size_t size) noexcept {
+	const auto record = reserve(size);
+	if (!record) {
+		return false;
+	}
+	memcpy(record, data, size);
+	publish(record);
+	return true;
+}
+
+void* SignalRing::reserve(std::size_t size) noexcept {
+	const auto need = sizeof(Header) + round(size);
+	auto head = m_head.load(std::memory_order_relaxed);
+	std::size_t pad = 0;
+	do {
+		const auto tail = m_tail.load(std::memory_order_acquire);
+		const auto offset = static_cast<std::size_t>(head % m_size);
+		pad = m_size - offset < need ? m_size - offset : 0;
+		if (need > m_size || head + pad + need - tail > m_size) {
+			m_dropped.fetch_add(1, std::memory_order_relaxed);
+			return nullptr;
+		}
+	} while (!m_head.compare_exchange_weak(head, head + pad + need, std::memory_order_relaxed));
+	if (pad) {
+		auto padding = header(head);
+		padding->size = static_cast<std::uint32_t>(pad - sizeof(Header));
+		__atomic_store_n(&padding->state, Padding, __ATOMIC_RELEASE);
+	}
+	auto record = header(head + pad);
+	record->size = static_cast<std::uint32_t>(size);
+	return record + 1;
+}
+
+void SignalRing::publish(void* record) noexcept {
+	__atomic_store_n(&(static_cast<Header*>(record) - 1)->state, Ready, __ATOMIC_RELEASE);
+}
+
+std::uint64_t SignalRing::dropped() const noexcept {
+	return m_dropped.load(std::memory_order_relaxed);
+}
+
+const void* SignalRing::peek(std::size_t& size) noexcept {
+	for (;;) {
+		const auto tail = m_tail.load(std::memory_order_relaxed);
+		auto h = header(tail);
+		const auto state = __atomic_load_n(&h->state, __ATOMIC_ACQUIRE);
+		if (state == Ready) {
+			size = h->size;
+			return h + 1;
+		}
+		if (state != Padding) {
+			size = 0;
+			return nullptr;
+		}
+		release(tail, sizeof(Header) + h->size);
+	}
+}
+
+void SignalRing::skip() noexcept {
+	const auto tail = m_tail.load(std::memory_order_relaxed);
+	release(tail, sizeof(Header) + round(header(tail)->size));
+}
+
+std::size_t SignalRing::get(void* data, std::size_t size) noexcept {
+	std::size_t record_size = 0;
+	const auto record = peek(record_size);
+	if (!record) {
+		return 0;
+	}
+	memcpy(data, record, record_size < size ? record_size : size);
+	skip();
+	return record_size;
+}
+
+SignalRing::Header* SignalRing::header(std::uint64_t position) const noexcept {
+	return reinterpret_cast<Header*>(m_buf + position % m_size);
+}
+
+void SignalRing::release(std::uint64_t position, std::size_t bytes) noexcept {
+	// Producers can't reach the bytes until the tail moves past them.
+	memset(header(position), 0, bytes);
+	m_tail.store(position + bytes, std::memory_order_release);
+}
+
+} // namespace bip
+
+#endif // BIP_SIGNAL_H_INCLUDED
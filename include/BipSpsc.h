@@ -0,0 +1,236 @@
+/*
+ * Wait-free single producer, single consumer bi-partitioned circular buffer.
+ */
+
+#ifndef BIP_SPSC_H_INCLUDED
+#define BIP_SPSC_H_INCLUDED
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+namespace bip {
+
+namespace internal {
+
+/*
+ * Shared cursor state. Data lies in [read, write) or, once the producer wrapped, in [read, last) then [0, write)
+ */
+struct Cursors {
+    static constexpr std::size_t cache_line = 64;
+
+    alignas(cache_line) std::atomic<std::size_t> write;
+    std::atomic<std::size_t> last;
+    alignas(cache_line) std::atomic<std::size_t> read;
+    char pad[cache_line - sizeof(std::atomic<std::size_t>)];
+}; // struct Cursors
+
+} // namespace internal
+
+template <typename T>
+class SPSC {
+public:
+    /*
+     * Construct a buffer at memory block 'buf', with total elements count 'size' (at least 2).
+     * One thread may call the producer methods while another calls the consumer methods
+     */
+    SPSC(T* buf, std::size_t size) noexcept;
+
+    /*
+     * Attach to a buffer at memory block 'buf' of 'size' elements whose state is kept in 'cursors',
+     * for instance in memory shared with another process
+     */
+    SPSC(T* buf, std::size_t size, internal::Cursors& cursors) noexcept;
+
+    SPSC(const SPSC&) = delete;
+    SPSC& operator=(const SPSC&) = delete;
+
+    /*
+     * Producer: attempt to write 'size' elements from 'data'. Returns the count of actual elements written
+     */
+    std::size_t put(const T* data, std::size_t size) noexcept;
+
+    /*
+     * Producer: returns the contiguous region available for writing and stores its element count in 'size'
+     */
+    inline T* reserve(std::size_t& size) noexcept;
+
+    /*
+     * Producer: publish 'size' elements of the reserved region. Returns the count of actual elements committed
+     */
+    inline std::size_t commit(std::size_t size) noexcept;
+
+    /*
+     * Producer: returns how many elements can be written in a single write
+     */
+    inline std::size_t free() noexcept;
+
+    /*
+     * Consumer: attempt to read 'size' elements into 'data'. Returns the count of actual elements read
+     */
+    std::size_t get(T* data, std::size_t size) noexcept;
+
+    /*
+     * Consumer: returns the contiguous region available for reading and stores its element count in 'size'
+     */
+    inline const T* peek(std::size_t& size) noexcept;
+
+    /*
+     * Consumer: attempt to skip 'size' elements. Returns the count of actual elements skipped
+     */
+    inline std::size_t skip(std::size_t size) noexcept;
+
+    /*
+     * Consumer: returns how many elements are available for a single read
+     */
+    inline std::size_t avail() noexcept;
+
+    /*
+     * Consumer: returns true if there are no elements available for read
+     */
+    inline bool empty() noexcept;
+
+    /*
+     * Consumer: returns true if there are any elements to be read
+     */
+    inline bool have() noexcept;
+
+private:
+    T* const m_buf;
+    const std::size_t m_size;
+    internal::Cursors m_local;
+    internal::Cursors& m_cursors;
+}; // class SPSC
+
+} // namespace bip
+
+namespace bip {
+
+template <typename T>
+SPSC<T>::SPSC(T* buf, std::size_t size) noexcept :
+		m_buf{buf},
+		m_size{size},
+		m_local{},
+		m_cursors(m_local) {
+	m_cursors.write.store(0, std::memory_order_relaxed);
+	m_cursors.last.store(0, std::memory_order_relaxed);
+	m_cursors.read.store(0, std::memory_order_relaxed);
+}
+
+template <typename T>
+SPSC<T>::SPSC(T* buf, std::size_t size, internal::Cursors& cursors) noexcept :
+		m_buf{buf},
+		m_size{size},
+		m_local{},
+		m_cursors(cursors) {
+}
+
+template <typename T>
+std::size_t SPSC<T>::put(const T* data, std::size_t size) noexcept {
+	std::size_t f = 0;
+	const auto out = reserve(f);
+	const auto n = std::min(size, f);
+	memcpy(out, data, n * sizeof(T));
+	return commit(n);
+}
+
+template <typename T>
+T* SPSC<T>::reserve(std::size_t& size) noexcept {
+	auto w = m_cursors.write.load(std::memory_order_relaxed);
+	const auto r = m_cursors.read.load(std::memory_order_acquire);
+	if (w < r) {
+		// Keep a gap so that a full buffer doesn't look empty.
+		size = r - w - 1;
+		return m_buf + w;
+	}
+	if (w == m_size && r > 0) {
+		m_cursors.last.store(w, std::memory_order_relaxed);
+		w = 0;
+		m_cursors.write.store(w, std::memory_order_release);
+		size = r - 1;
+		return m_buf;
+	}
+	size = m_size - w;
+	return m_buf + w;
+}
+
+template <typename T>
+std::size_t SPSC<T>::commit(std::size_t size) noexcept {
+	std::size_t f = 0;
+	reserve(f);
+	const auto n = std::min(size, f);
+	const auto w = m_cursors.write.load(std::memory_order_relaxed);
+	m_cursors.write.store(w + n, std::memory_order_release);
+	return n;
+}
+
+template <typename T>
+std::size_t SPSC<T>::free() noexcept {
+	std::size_t size = 0;
+	reserve(size);
+	return size;
+}
+
+template <typename T>
+std::size_t SPSC<T>::get(T* data, std::size_t size) noexcept {
+	std::size_t a = 0;
+	const auto in = peek(a);
+	const auto n = std::min(size, a);
+	memcpy(data, in, n * sizeof(T));
+	return skip(n);
+}
+
+template <typename T>
+const T* SPSC<T>::peek(std::size_t& size) noexcept {
+	auto r = m_cursors.read.load(std::memory_order_relaxed);
+	const auto w = m_cursors.write.load(std::memory_order_acquire);
+	if (w >= r) {
+		size = w - r;
+		return m_buf + r;
+	}
+	const auto l = m_cursors.last.load(std::memory_order_relaxed);
+	if (r == l) {
+		r = 0;
+		m_cursors.read.store(r, std::memory_order_release);
+		size = w;
+		return m_buf;
+	}
+	size = l - r;
+	return m_buf + r;
+}
+
+template <typename T>
+std::size_t SPSC<T>::skip(std::size_t size) noexcept {
+	std::size_t a = 0;
+	const auto in = peek(a);
+	const auto n = std::min(size, a);
+	auto r = static_cast<std::size_t>(in - m_buf) + n;
+	if (r > m_cursors.write.load(std::memory_order_acquire) && r == m_cursors.last.load(std::memory_order_relaxed)) {
+		// Follow the producer's wrap right away so that it sees the space.
+		r = 0;
+	}
+	m_cursors.read.store(r, std::memory_order_release);
+	return n;
+}
+
+template <typename T>
+std::size_t SPSC<T>::avail() noexcept {
+	std::size_t size = 0;
+	peek(size);
+	return size;
+}
+
+template <typename T>
+bool SPSC<T>::empty() noexcept {
+	return avail() == 0;
+}
+
+template <typename T>
+bool SPSC<T>::have() noexcept {
+	return !empty();
+}
+
+} // namespace bip
+
+#endif // BIP_SPSC_H_INCLUDED
@@ -0,0 +1,241 @@
+/*
+ * Per-tenant quotas on records sharing one bi-partitioned circular buffer.
+ */
+
+#ifndef BIP_TENANTS_H_INCLUDED
+#define BIP_TENANTS_H_INCLUDED
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "Bip.h"
+
+namespace bip {
+
+/*
+ * Records tagged with their tenant, each contiguous in one partition. A tenant's in-flight bytes are charged on put and
+ * credited on skip from the tag, so accounting is constant time whatever the number of tenants. A put that would take
+ * a tenant past its quota is refused while the others proceed, and the caller may spill the record elsewhere.
+ * Not thread safe, as BIP<T>: from threads, call it inside Blocking<char>::locked()
+ */
+class Tenants {
+public:
+    /*
+     * Outcome of put()
+     */
+    enum class Status {
+        Written,    // the record is in the buffer
+        OverQuota,  // it would take the tenant past its quota, counted in refused()
+        Full,       // not enough contiguous space now, retry once records are read
+        TooLarge,   // it would not fit even in the empty buffer
+        BadTenant,  // the tenant is out of range
+        Empty,      // the record has no bytes, which get() couldn't tell apart from no record
+    };
+
+    /*
+     * Carry records of 'tenants' tenants in empty BIP buffer 'bip', allowing each 'quota' bytes in flight, record tags
+     * included. Throws std::invalid_argument if 'bip' isn't empty or 'tenants' can't be tagged
+     */
+    Tenants(BIP<char>& bip, std::size_t tenants, std::size_t quota);
+
+    Tenants(const Tenants&) = delete;
+    Tenants& operator=(const Tenants&) = delete;
+
+    /*
+     * Attempt to write a record of 'size' (at least 1) bytes from 'data' for tenant 'tenant'. Returns Status::Written
+     * on success
+     */
+    Status put(std::size_t tenant, const void* data, std::size_t size) noexcept;
+
+    /*
+     * Returns the next record, storing its byte count in 'size' and its tenant in 'tenant', or nullptr if there is none
+     */
+    const char* peek(std::size_t& size, std::size_t& tenant) noexcept;
+
+    /*
+     * Release the record returned by peek(), crediting its tenant
+     */
+    void skip() noexcept;
+
+    /*
+     * Attempt to read the next record into 'data' of 'size' bytes, truncating it if needed, and store its tenant in
+     * 'tenant'. Returns the record byte count, never 0 for a record, or 0 if there is none
+     */
+    std::size_t get(void* data, std::size_t size, std::size_t& tenant) noexcept;
+
+    /*
+     * Returns the count of tenants. The accessors below take a tenant less than it
+     */
+    inline std::size_t tenants() const noexcept;
+
+    /*
+     * Allow tenant 'tenant' 'quota' bytes in flight. Records already written stay
+     */
+    inline void set_quota(std::size_t tenant, std::size_t quota) noexcept;
+
+    /*
+     * Returns the bytes tenant 'tenant' may have in flight
+     */
+    inline std::size_t quota(std::size_t tenant) const noexcept;
+
+    /*
+     * Returns the bytes tenant 'tenant' has in flight, record tags included
+     */
+    inline std::size_t used(std::size_t tenant) const noexcept;
+
+    /*
+     * Returns how many records of tenant 'tenant' were refused for its quota
+     */
+    inline std::uint64_t refused(std::size_t tenant) const noexcept;
+
+    /*
+     * Returns true if there are no records to be read
+     */
+    inline bool empty() const noexcept;
+
+private:
+    struct Tag {
+        static constexpr std::uint32_t padding = UINT32_MAX;
+
+        std::uint32_t size;
+        std::uint32_t tenant;
+    }; // struct Tag
+
+    struct Account {
+        std::size_t quota;
+        std::size_t used;
+        std::uint64_t refused;
+    }; // struct Account
+
+    BIP<char>& m_bip;
+    const std::size_t m_capacity;
+    std::vector<Account> m_accounts;
+}; // class Tenants
+
+} // namespace bip
+
+namespace bip {
+
+inline Tenants::Tenants(BIP<char>& bip, std::size_t tenants, std::size_t quota) :
+		m_bip(bip),
+		m_capacity{bip.space()},
+		m_accounts{} {
+	// Tenants are tagged below Tag::padding.
+	if (!bip.empty() || tenants > Tag::padding) {
+		throw std::invalid_argument{"Tenant buffer or count"};
+	}
+	m_accounts.assign(tenants, Account{quota, 0, 0});
+}
+
+inline auto Tenants::put(std::size_t tenant, const void* data, std::size_t size) noexcept -> Status {
+	if (tenant >= m_accounts.size()) {
+		return Status::BadTenant;
+	}
+	if (size == 0) {
+		return Status::Empty;
+	}
+	const auto need = sizeof(Tag) + size;
+	if (size >= Tag::padding || need > m_capacity) {
+		return Status::TooLarge;
+	}
+	auto& account = m_accounts[tenant];
+	if (account.used + need > account.quota) {
+		++account.refused;
+		return Status::OverQuota;
+	}
+	std::size_t f = 0;
+	auto out = m_bip.reserve(f);
+	if (f < need) {
+		// Pad out the Put partition so that it switches, unless the record doesn't fit after the switch either.
+		if (m_bip.space() - f < need) {
+			return Status::Full;
+		}
+		if (f >= sizeof(Tag)) {
+			const Tag tag{static_cast<std::uint32_t>(f - sizeof(Tag)), Tag::padding};
+			memcpy(out, &tag, sizeof(tag));
+		}
+		m_bip.commit(f);
+		out = m_bip.reserve(f);
+		if (f < need) {
+			return Status::Full;
+		}
+	}
+	const Tag tag{static_cast<std::uint32_t>(size), static_cast<std::uint32_t>(tenant)};
+	memcpy(out, &tag, sizeof(tag));
+	memcpy(out + sizeof(tag), data, size);
+	m_bip.commit(need);
+	account.used += need;
+	return Status::Written;
+}
+
+inline const char* Tenants::peek(std::size_t& size, std::size_t& tenant) noexcept {
+	for (;;) {
+		std::size_t a = 0;
+		const auto in = m_bip.peek(a);
+		if (a == 0) {
+			size = 0;
+			return nullptr;
+		}
+		if (a >= sizeof(Tag)) {
+			Tag tag;
+			memcpy(&tag, in, sizeof(tag));
+			if (tag.tenant != Tag::padding) {
+				size = tag.size;
+				tenant = tag.tenant;
+				return in + sizeof(Tag);
+			}
+		}
+		// Padding, too short for a tag or not, runs to the end of the partition.
+		m_bip.skip(a);
+	}
+}
+
+inline void Tenants::skip() noexcept {
+	std::size_t size = 0;
+	std::size_t tenant = 0;
+	if (peek(size, tenant)) {
+		m_accounts[tenant].used -= sizeof(Tag) + size;
+		m_bip.skip(sizeof(Tag) + size);
+	}
+}
+
+inline std::size_t Tenants::get(void* data, std::size_t size, std::size_t& tenant) noexcept {
+	std::size_t record_size = 0;
+	const auto record = peek(record_size, tenant);
+	if (!record) {
+		return 0;
+	}
+	memcpy(data, record, record_size < size ? record_size : size);
+	skip();
+	return record_size;
+}
+
+std::size_t Tenants::tenants() const noexcept {
+	return m_accounts.size();
+}
+
+void Tenants::set_quota(std::size_t tenant, std::size_t quota) noexcept {
+	m_accounts[tenant].quota = quota;
+}
+
+std::size_t Tenants::quota(std::size_t tenant) const noexcept {
+	return m_accounts[tenant].quota;
+}
+
+std::size_t Tenants::used(std::size_t tenant) const noexcept {
+	return m_accounts[tenant].used;
+}
+
+std::uint64_t Tenants::refused(std::size_t tenant) const noexcept {
+	return m_accounts[tenant].refused;
+}
+
+bool Tenants::empty() const noexcept {
+	return m_bip.empty();
+}
+
+} // namespace bip
+
+#endif // BIP_TENANTS_H_INCLUDED
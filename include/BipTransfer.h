@@ -0,0 +1,62 @@
+/*
+ * Moving elements between bi-partitioned circular buffers without an intermediate copy.
+ */
+
+#ifndef BIP_TRANSFER_H_INCLUDED
+#define BIP_TRANSFER_H_INCLUDED
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "Bip.h"
+#include "BipSpsc.h"
+
+namespace bip {
+
+namespace internal {
+
+template <typename Src, typename Dst, typename T>
+std::size_t transfer(Src& src, Dst& dst, std::size_t size) noexcept {
+	std::size_t moved = 0;
+	// Each pass copies the overlap of one readable and one writable region, so either side may cross a partition boundary.
+	while (moved < size) {
+		std::size_t a = 0;
+		std::size_t f = 0;
+		const T* in = src.peek(a);
+		T* out = dst.reserve(f);
+		const auto n = std::min(size - moved, std::min(a, f));
+		if (n == 0) {
+			break;
+		}
+		memcpy(out, in, n * sizeof(T));
+		dst.commit(n);
+		src.skip(n);
+		moved += n;
+	}
+	return moved;
+}
+
+} // namespace internal
+
+/*
+ * Move up to 'size' elements from 'src' to 'dst' with one copy per element, straight from the readable regions of 'src'
+ * into the writable regions of 'dst'. Returns the count of actual elements moved
+ */
+template <typename T>
+std::size_t transfer(BIP<T>& src, BIP<T>& dst, std::size_t size) noexcept {
+	return internal::transfer<BIP<T>, BIP<T>, T>(src, dst, size);
+}
+
+/*
+ * As above, from the consumer side of 'src' to the producer side of 'dst', so that a thread consuming one and producing
+ * the other may route between them while their other sides run concurrently
+ */
+template <typename T>
+std::size_t transfer(SPSC<T>& src, SPSC<T>& dst, std::size_t size) noexcept {
+	return internal::transfer<SPSC<T>, SPSC<T>, T>(src, dst, size);
+}
+
+} // namespace bip
+
+#endif // BIP_TRANSFER_H_INCLUDED
@@ -0,0 +1,246 @@
+/*
+ * UTF-8 validation of text written into a bi-partitioned circular buffer.
+ */
+
+#ifndef BIP_UTF8_H_INCLUDED
+#define BIP_UTF8_H_INCLUDED
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "Bip.h"
+
+namespace bip {
+
+/*
+ * Incremental UTF-8 validator. Text may be fed in pieces split anywhere, including inside a sequence
+ */
+class Utf8Validator {
+public:
+    Utf8Validator() noexcept;
+
+    /*
+     * Validate the next 'size' bytes at 'data'. Returns false once the text is invalid
+     */
+    bool feed(const char* data, std::size_t size) noexcept;
+
+    /*
+     * Returns the byte count from the start of the text up to the end of its last complete, valid character
+     */
+    inline std::uint64_t validated() const noexcept;
+
+    /*
+     * Returns false if an invalid byte was found
+     */
+    inline bool valid() const noexcept;
+
+    /*
+     * Returns the offset of the first invalid byte, if any
+     */
+    inline std::uint64_t error() const noexcept;
+
+    /*
+     * Returns true if the text fed so far doesn't end inside a sequence
+     */
+    inline bool complete() const noexcept;
+
+private:
+    std::uint64_t m_offset;
+    std::uint64_t m_validated;
+    unsigned m_need;
+    unsigned char m_lower;
+    unsigned char m_upper;
+    bool m_valid;
+}; // class Utf8Validator
+
+/*
+ * Write text into BIP buffer 'bip', validating each span in place right after it is copied while it is still in cache.
+ * Nothing from the first invalid byte on is committed. Readers may consume up to validated() bytes of the text, counted
+ * from the first one written, as the bytes just before an invalid one may start a sequence it cut short
+ */
+class Utf8Writer {
+public:
+    explicit Utf8Writer(BIP<char>& bip) noexcept;
+
+    /*
+     * Attempt to write 'size' bytes from 'data'. Returns the count of actual bytes written, which stops short of the
+     * first invalid byte, and is 0 once the text is invalid
+     */
+    std::size_t put(const char* data, std::size_t size) noexcept;
+
+    /*
+     * Returns the contiguous region available for writing and stores its byte count in 'size'
+     */
+    inline char* reserve(std::size_t& size) noexcept;
+
+    /*
+     * Validate and write 'size' bytes of the reserved region, up to the first invalid byte.
+     * Returns the count of actual bytes committed
+     */
+    std::size_t commit(std::size_t size) noexcept;
+
+    /*
+     * Returns the state of the validation of everything written
+     */
+    inline const Utf8Validator& validator() const noexcept;
+
+    /*
+     * Returns the byte count of written text that is validated complete characters
+     */
+    inline std::uint64_t validated() const noexcept;
+
+    /*
+     * Returns false if invalid text was written
+     */
+    inline bool valid() const noexcept;
+
+private:
+    BIP<char>& m_bip;
+    Utf8Validator m_validator;
+}; // class Utf8Writer
+
+} // namespace bip
+
+namespace bip {
+
+inline Utf8Validator::Utf8Validator() noexcept :
+		m_offset{},
+		m_validated{},
+		m_need{},
+		m_lower{0x80},
+		m_upper{0xbf},
+		m_valid{true} {
+}
+
+inline bool Utf8Validator::feed(const char* data, std::size_t size) noexcept {
+	if (!m_valid) {
+		return false;
+	}
+	auto in = reinterpret_cast<const unsigned char*>(data);
+	const auto end = in + size;
+	while (in != end) {
+		if (m_need == 0) {
+#if defined(__SSE2__)
+			// Skip ASCII 16 bytes at a time.
+			while (end - in >= 16 && _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in))) == 0) {
+				in += 16;
+			}
+#endif
+			while (in != end && *in < 0x80) {
+				++in;
+			}
+			m_validated = m_offset + static_cast<std::uint64_t>(in - reinterpret_cast<const unsigned char*>(data));
+			if (in == end) {
+				break;
+			}
+			// Lead byte, with the range of the byte after it excluding overlong forms, surrogates and values past U+10FFFF.
+			const auto lead = *in;
+			m_lower = 0x80;
+			m_upper = 0xbf;
+			if (lead >= 0xc2 && lead <= 0xdf) {
+				m_need = 1;
+			} else if (lead >= 0xe0 && lead <= 0xef) {
+				m_need = 2;
+				m_lower = lead == 0xe0 ? 0xa0 : 0x80;
+				m_upper = lead == 0xed ? 0x9f : 0xbf;
+			} else if (lead >= 0xf0 && lead <= 0xf4) {
+				m_need = 3;
+				m_lower = lead == 0xf0 ? 0x90 : 0x80;
+				m_upper = lead == 0xf4 ? 0x8f : 0xbf;
+			} else {
+				break;
+			}
+			++in;
+			continue;
+		}
+		if (*in < m_lower || *in > m_upper) {
+			break;
+		}
+		m_lower = 0x80;
+		m_upper = 0xbf;
+		++in;
+		if (--m_need == 0) {
+			m_validated = m_offset + static_cast<std::uint64_t>(in - reinterpret_cast<const unsigned char*>(data));
+		}
+	}
+	m_offset += static_cast<std::uint64_t>(in - reinterpret_cast<const unsigned char*>(data));
+	m_valid = in == end;
+	return m_valid;
+}
+
+std::uint64_t Utf8Validator::validated() const noexcept {
+	return m_validated;
+}
+
+bool Utf8Validator::valid() const noexcept {
+	return m_valid;
+}
+
+std::uint64_t Utf8Validator::error() const noexcept {
+	return m_offset;
+}
+
+bool Utf8Validator::complete() const noexcept {
+	return m_need == 0;
+}
+
+inline Utf8Writer::Utf8Writer(BIP<char>& bip) noexcept :
+		m_bip(bip),
+		m_validator{} {
+}
+
+inline std::size_t Utf8Writer::put(const char* data, std::size_t size) noexcept {
+	std::size_t written = 0;
+	// The second pass continues in the other partition after a switch.
+	for (int pass = 0; pass < 2 && written < size; ++pass) {
+		std::size_t f = 0;
+		const auto out = reserve(f);
+		const auto n = std::min(size - written, f);
+		if (n == 0) {
+			break;
+		}
+		memcpy(out, data + written, n);
+		const auto c = commit(n);
+		written += c;
+		if (c < n) {
+			break;
+		}
+	}
+	return written;
+}
+
+char* Utf8Writer::reserve(std::size_t& size) noexcept {
+	return m_bip.reserve(size);
+}
+
+inline std::size_t Utf8Writer::commit(std::size_t size) noexcept {
+	std::size_t f = 0;
+	const auto out = m_bip.reserve(f);
+	auto n = std::min(size, f);
+	const auto fed = m_validator.error();
+	if (!m_validator.feed(out, n)) {
+		n = static_cast<std::size_t>(m_validator.error() - fed);
+	}
+	return m_bip.commit(n);
+}
+
+const Utf8Validator& Utf8Writer::validator() const noexcept {
+	return m_validator;
+}
+
+std::uint64_t Utf8Writer::validated() const noexcept {
+	return m_validator.validated();
+}
+
+bool Utf8Writer::valid() const noexcept {
+	return m_validator.valid();
+}
+
+} // namespace bip
+
+#endif // BIP_UTF8_H_INCLUDED
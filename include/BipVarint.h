@@ -0,0 +1,288 @@
+/*
+ * LEB128 varint encoded integer streams over a bi-partitioned circular buffer.
+ */
+
+#ifndef BIP_VARINT_H_INCLUDED
+#define BIP_VARINT_H_INCLUDED
+
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "Bip.h"
+
+namespace bip {
+
+/*
+ * Maximum encoded length of a 64-bit varint
+ */
+constexpr std::size_t varint_max = 10;
+
+/*
+ * Map signed 'value' to unsigned so that small magnitudes encode short
+ */
+inline std::uint64_t zigzag(std::int64_t value) noexcept;
+
+/*
+ * Inverse of zigzag()
+ */
+inline std::int64_t unzigzag(std::uint64_t value) noexcept;
+
+/*
+ * Encode 'value' into 'out', which must hold varint_max bytes. Returns the encoded length
+ */
+inline std::size_t varint_encode(std::uint64_t value, unsigned char* out) noexcept;
+
+/*
+ * Decode a varint from ['in', 'end') into 'value'. Returns past its last byte, or nullptr if it is incomplete
+ */
+inline const unsigned char* varint_decode(const unsigned char* in, const unsigned char* end, std::uint64_t& value) noexcept;
+
+class VarintWriter {
+public:
+    /*
+     * Write varints into BIP buffer 'bip'
+     */
+    explicit VarintWriter(BIP<char>& bip) noexcept;
+
+    /*
+     * Attempt to write 'value'. Returns false if it doesn't fit
+     */
+    inline bool put(std::uint64_t value) noexcept;
+
+    /*
+     * Attempt to write zigzag encoded 'value'. Returns false if it doesn't fit
+     */
+    inline bool put_signed(std::int64_t value) noexcept;
+
+    /*
+     * Attempt to write 'count' values from 'values'. Returns the count of actual values written
+     */
+    std::size_t put(const std::uint64_t* values, std::size_t count) noexcept;
+
+private:
+    BIP<char>& m_bip;
+}; // class VarintWriter
+
+class VarintReader {
+public:
+    /*
+     * Read varints from BIP buffer 'bip'
+     */
+    explicit VarintReader(BIP<char>& bip) noexcept;
+
+    /*
+     * Attempt to read a value into 'value'. Returns false if no complete value is available
+     */
+    inline bool get(std::uint64_t& value) noexcept;
+
+    /*
+     * Attempt to read a zigzag encoded value into 'value'. Returns false if no complete value is available
+     */
+    inline bool get_signed(std::int64_t& value) noexcept;
+
+    /*
+     * Attempt to read 'count' values into 'values'. Returns the count of actual values read.
+     * Bytes of an incomplete trailing value are consumed and kept until the rest arrives
+     */
+    std::size_t get(std::uint64_t* values, std::size_t count) noexcept;
+
+private:
+    BIP<char>& m_bip;
+    unsigned char m_pending[varint_max];
+    std::size_t m_pending_size;
+}; // class VarintReader
+
+namespace internal {
+
+/*
+ * Decode complete varints from ['in', 'end') into 'values' until 'count' are read. Returns past the last decoded byte
+ */
+inline const unsigned char* varint_decode_bulk(const unsigned char* in, const unsigned char* end, std::uint64_t* values, std::size_t count, std::size_t& read) noexcept;
+
+} // namespace internal
+
+} // namespace bip
+
+namespace bip {
+
+std::uint64_t zigzag(std::int64_t value) noexcept {
+	return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+std::int64_t unzigzag(std::uint64_t value) noexcept {
+	return static_cast<std::int64_t>((value >> 1) ^ (~(value & 1) + 1));
+}
+
+std::size_t varint_encode(std::uint64_t value, unsigned char* out) noexcept {
+	std::size_t size = 0;
+	while (value >= 0x80) {
+		out[size++] = static_cast<unsigned char>(value | 0x80);
+		value >>= 7;
+	}
+	out[size++] = static_cast<unsigned char>(value);
+	return size;
+}
+
+const unsigned char* varint_decode(const unsigned char* in, const unsigned char* end, std::uint64_t& value) noexcept {
+	std::uint64_t result = 0;
+	for (unsigned shift = 0; in != end; shift += 7) {
+		const auto byte = *in++;
+		result |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+		if (!(byte & 0x80) || shift == 7 * (varint_max - 1)) {
+			value = result;
+			return in;
+		}
+	}
+	return nullptr;
+}
+
+inline VarintWriter::VarintWriter(BIP<char>& bip) noexcept :
+		m_bip(bip) {
+}
+
+bool VarintWriter::put(std::uint64_t value) noexcept {
+	unsigned char encoded[varint_max];
+	const auto size = varint_encode(value, encoded);
+	if (m_bip.space() < size) {
+		return false;
+	}
+	const auto data = reinterpret_cast<const char*>(encoded);
+	const auto written = m_bip.put(data, size);
+	m_bip.put(data + written, size - written);
+	return true;
+}
+
+bool VarintWriter::put_signed(std::int64_t value) noexcept {
+	return put(zigzag(value));
+}
+
+inline std::size_t VarintWriter::put(const std::uint64_t* values, std::size_t count) noexcept {
+	std::size_t written = 0;
+	while (written < count) {
+		std::size_t size = 0;
+		auto out = reinterpret_cast<unsigned char*>(m_bip.reserve(size));
+		std::size_t used = 0;
+		while (written < count && size - used >= varint_max) {
+			used += varint_encode(values[written++], out + used);
+		}
+		m_bip.commit(used);
+		// Near the end of the partition, encode one value at a time across the switch.
+		if (written < count && size - used < varint_max) {
+			if (!put(values[written])) {
+				break;
+			}
+			++written;
+		}
+	}
+	return written;
+}
+
+inline VarintReader::VarintReader(BIP<char>& bip) noexcept :
+		m_bip(bip),
+		m_pending{},
+		m_pending_size{} {
+}
+
+bool VarintReader::get(std::uint64_t& value) noexcept {
+	return get(&value, 1) == 1;
+}
+
+bool VarintReader::get_signed(std::int64_t& value) noexcept {
+	std::uint64_t encoded = 0;
+	if (!get(encoded)) {
+		return false;
+	}
+	value = unzigzag(encoded);
+	return true;
+}
+
+inline std::size_t VarintReader::get(std::uint64_t* values, std::size_t count) noexcept {
+	std::size_t read = 0;
+	while (read < count) {
+		std::size_t size = 0;
+		const auto span = reinterpret_cast<const unsigned char*>(m_bip.peek(size));
+		if (size == 0) {
+			break;
+		}
+		const auto end = span + size;
+		auto in = span;
+		if (m_pending_size) {
+			// Complete the value split by the previous span.
+			while (in != end && m_pending_size < varint_max) {
+				const auto byte = *in++;
+				m_pending[m_pending_size++] = byte;
+				if (!(byte & 0x80)) {
+					break;
+				}
+			}
+			if (varint_decode(m_pending, m_pending + m_pending_size, values[read])) {
+				++read;
+				m_pending_size = 0;
+			}
+		}
+		std::size_t decoded = 0;
+		in = internal::varint_decode_bulk(in, end, values + read, count - read, decoded);
+		read += decoded;
+		if (read < count && in != end) {
+			// The span ends inside a value.
+			while (in != end) {
+				m_pending[m_pending_size++] = *in++;
+			}
+		}
+		m_bip.skip(in - span);
+	}
+	return read;
+}
+
+namespace internal {
+
+const unsigned char* varint_decode_bulk(const unsigned char* in, const unsigned char* end, std::uint64_t* values, std::size_t count, std::size_t& read) noexcept {
+	read = 0;
+#if defined(__SSE2__)
+	// Locate value terminators 16 bytes at a time.
+	while (read < count && end - in >= 16) {
+		const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+		auto stops = ~static_cast<unsigned>(_mm_movemask_epi8(block)) & 0xffff;
+		if (stops == 0xffff && count - read >= 16) {
+			for (unsigned i = 0; i < 16; ++i) {
+				values[read + i] = in[i];
+			}
+			read += 16;
+			in += 16;
+			continue;
+		}
+		const auto base = in;
+		while (stops && read < count) {
+			const auto last = base + __builtin_ctz(stops);
+			std::uint64_t value = 0;
+			for (unsigned shift = 0; in <= last && shift < 64; shift += 7) {
+				value |= static_cast<std::uint64_t>(*in++ & 0x7f) << shift;
+			}
+			in = last + 1;
+			values[read++] = value;
+			stops &= stops - 1;
+		}
+		if (in == base) {
+			// No value ends within the block.
+			break;
+		}
+	}
+#endif
+	while (read < count) {
+		const auto next = varint_decode(in, end, values[read]);
+		if (!next) {
+			break;
+		}
+		in = next;
+		++read;
+	}
+	return in;
+}
+
+} // namespace internal
+} // namespace bip
+
+#endif // BIP_VARINT_H_INCLUDED
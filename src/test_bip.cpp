@@ -3,14 +3,46 @@
 #include <algorithm>
 #include <iterator>
 #include <limits>
+#include <string>
+#include <cstring>
 #include <array>
 #include <thread>
 #include <functional>
 #include <iostream>
 #include <mutex>
 #include <condition_variable>
+#include <chrono>
+#include <atomic>
+#include <csignal>
+#include <stdexcept>
+#include <system_error>
+#include <deque>
+
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include "Bip.h"
+#include "BipAggregate.h"
+#include "BipArena.h"
+#include "BipBuffer.h"
+#include "BipColumns.h"
+#include "BipDirect.h"
+#include "BipFile.h"
+#include "BipGroup.h"
+#include "BipLanes.h"
+#include "BipLz.h"
+#include "BipMapped.h"
+#include "BipRateLimit.h"
+#include "BipRealtime.h"
+#include "BipReserved.h"
+#include "BipShared.h"
+#include "BipSignal.h"
+#include "BipTenants.h"
+#include "BipTransfer.h"
+#include "BipUtf8.h"
+#include "BipVarint.h"
 
 using elem_type = char;
 constexpr size_t buf_size = 200;
@@ -61,11 +93,41 @@ static std::default_random_engine& random_engine() {
 	return engine;
 }
 
+static bool test_wrap() {
+	// Uneven reads and writes around the end of a small buffer must keep order and never leave data unreadable.
+	constexpr size_t wrap_size = 8;
+	std::array<elem_type, wrap_size> buf;
+	bip::BIP<elem_type> bip{buf.data(), buf.size()};
+	std::default_random_engine engine {3};
+	std::uniform_int_distribution<size_t> dist {1, wrap_size - 2};
+	elem_type next_in = 0;
+	elem_type next_out = 0;
+	elem_type chunk[wrap_size];
+	for (size_t i = 0; i < 10000; ++i) {
+		const auto size = dist(engine);
+		for (size_t j = 0; j < size; ++j) {
+			chunk[j] = static_cast<elem_type>(next_in + j);
+		}
+		next_in = static_cast<elem_type>(next_in + bip.put(chunk, size));
+		const auto read = bip.get(chunk, dist(engine));
+		if (read == 0 && next_out != next_in) {
+			return false;
+		}
+		for (size_t j = 0; j < read; ++j) {
+			if (chunk[j] != next_out++) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
 static void produce(bip::BIP<elem_type>& bip, const std::vector<elem_type>& in_data, bip_threading& threading) {
+	std::default_random_engine engine {1};
 	std::uniform_int_distribution<size_t> dist {min_produce_len, max_produce_len};
 	size_t left = in_data.size();
 	while (left > 0) {
-		auto size = std::min(dist(random_engine()), left);
+		auto size = std::min(dist(engine), left);
 		size_t written = 0;
 		{
 			auto lock = threading.lock();
@@ -79,10 +141,11 @@ static void produce(bip::BIP<elem_type>& bip, const std::vector<elem_type>& in_d
 
 static void consume(bip::BIP<elem_type>& bip, std::vector<elem_type>& out_data, size_t total, bip_threading& threading) {
 	std::uniform_int_distribution<size_t> dist {min_consume_len, max_consume_len};
+	std::default_random_engine engine {2};
 	elem_type buf[max_consume_len];
 	size_t left = total;
 	while (left > 0) {
-		auto size = std::min(dist(random_engine()), left);
+		auto size = std::min(dist(engine), left);
 		size_t read = 0;
 		{
 			auto lock = threading.lock();
@@ -108,6 +171,1001 @@ static std::vector<elem_type> generate(size_t count) {
 	return out_data;
 }
 
+static bool test_arena(const std::vector<elem_type>& in_data) {
+	bip::Arena<elem_type> arena{{{64, 1}, {16, 2}}};
+
+	// The smallest free class that fits, then the next one up once it is exhausted.
+	const auto a = arena.acquire(10);
+	const auto b = arena.acquire(16);
+	const auto c = arena.acquire(1);
+	if (!a || !b || !c || arena.capacity(a) != 16 || arena.capacity(b) != 16 || arena.capacity(c) != 64 ||
+			arena.acquire(1) || arena.acquire(65)) {
+		return false;
+	}
+
+	// Buffers don't overlap.
+	bip::BIP<elem_type>* const buffers[] = {a, b, c};
+	for (size_t i = 0; i < 3; ++i) {
+		if (buffers[i]->put(in_data.data() + i * 64, arena.capacity(buffers[i])) != arena.capacity(buffers[i])) {
+			return false;
+		}
+	}
+	for (size_t i = 0; i < 3; ++i) {
+		elem_type out[64];
+		const auto read = buffers[i]->get(out, sizeof(out));
+		if (read != arena.capacity(buffers[i]) || !std::equal(out, out + read, in_data.data() + i * 64)) {
+			return false;
+		}
+	}
+
+	// Only acquired buffers of this arena go back, once, and are reused.
+	bip::BIP<elem_type> foreign{nullptr, 0};
+	const auto inside = reinterpret_cast<bip::BIP<elem_type>*>(reinterpret_cast<unsigned char*>(b) + 8);
+	if (arena.release(nullptr) || arena.release(&foreign) || arena.release(inside) || arena.capacity(inside) != 0 ||
+			!arena.release(a) || arena.release(a)) {
+		return false;
+	}
+	return arena.acquire(16) == a && arena.acquire(16) == nullptr && arena.bytes() > 0;
+}
+
+static bool test_varint(const std::vector<elem_type>& in_data) {
+	std::array<char, buf_size> buf;
+	bip::BIP<char> bip{buf.data(), buf.size()};
+	bip::VarintWriter writer{bip};
+	bip::VarintReader reader{bip};
+
+	std::vector<std::uint64_t> values;
+	for (size_t i = 0; i + 1 < in_data.size(); i += 2) {
+		values.push_back(bip::zigzag(static_cast<std::int64_t>(in_data[i]) * (std::int64_t{1} << (in_data[i + 1] & 0x37))));
+	}
+
+	std::vector<std::uint64_t> decoded(values.size());
+	size_t written = 0;
+	size_t read = 0;
+	while (read < values.size()) {
+		written += writer.put(values.data() + written, std::min<size_t>(values.size() - written, 37));
+		read += reader.get(decoded.data() + read, decoded.size() - read);
+	}
+	return decoded == values;
+}
+
+static bool test_columns(const std::vector<elem_type>& in_data) {
+	std::array<std::uint64_t, buf_size> stamps;
+	std::array<double, buf_size> values;
+	bip::Columns<std::uint64_t, double> columns{buf_size, stamps.data(), values.data()};
+
+	std::vector<std::uint64_t> in_stamps(in_data.size());
+	std::vector<double> in_values(in_data.size());
+	for (size_t i = 0; i < in_data.size(); ++i) {
+		in_stamps[i] = i;
+		in_values[i] = in_data[i] * 0.5;
+	}
+
+	std::vector<std::uint64_t> out_stamps;
+	std::vector<double> out_values;
+	size_t written = 0;
+	while (out_stamps.size() < in_data.size()) {
+		const auto count = std::min<size_t>(in_data.size() - written, 73);
+		written += columns.put(count, in_stamps.data() + written, in_values.data() + written);
+		const std::uint64_t* stamp_span = nullptr;
+		const double* value_span = nullptr;
+		const auto read = std::min<size_t>(columns.peek(stamp_span, value_span), 51);
+		out_stamps.insert(std::end(out_stamps), stamp_span, stamp_span + read);
+		out_values.insert(std::end(out_values), value_span, value_span + read);
+		columns.skip(read);
+	}
+	return out_stamps == in_stamps && out_values == in_values;
+}
+
+static bool test_lz(const std::vector<elem_type>& in_data) {
+	// Random input followed by a compressible repetition of it.
+	std::vector<char> data(std::begin(in_data), std::end(in_data));
+	for (size_t i = 0; i < 4 * in_data.size(); ++i) {
+		data.push_back(in_data[i % 300]);
+	}
+
+	std::array<char, 3000> in_buf, mid_buf, out_buf;
+	bip::BIP<char> in{in_buf.data(), in_buf.size()};
+	bip::BIP<char> mid{mid_buf.data(), mid_buf.size()};
+	bip::BIP<char> out{out_buf.data(), out_buf.size()};
+	bip::LzCompressor compressor{1000};
+	bip::LzDecompressor decompressor{1000};
+
+	std::vector<char> result;
+	char chunk[max_consume_len];
+	size_t written = 0;
+	size_t compressed = 0;
+	while (result.size() < data.size() && !decompressor.failed()) {
+		const auto put = in.put(data.data() + written, std::min<size_t>(data.size() - written, 777));
+		written += put;
+		const auto before = mid.size();
+		const auto consumed = compressor.compress(in, mid, written == data.size());
+		compressed += mid.size() - before;
+		const auto produced = decompressor.decompress(mid, out);
+		const auto read = out.get(chunk, sizeof(chunk));
+		result.insert(std::end(result), chunk, chunk + read);
+		if (put + consumed + produced + read == 0 && mid.size() == before) {
+			std::cerr << "LZ stopped making progress." << std::endl;
+			return false;
+		}
+	}
+	// The repetition takes four fifths of the input and compresses to next to nothing.
+	if (result != data || compressed >= data.size() / 2) {
+		return false;
+	}
+
+	// Entries left by earlier blocks miss, and positions wrapping past 32 bits restart the table.
+	std::vector<std::uint32_t> table(1u << bip::LzCompressor::hash_bits, UINT32_MAX - 1500);
+	std::uint32_t base = UINT32_MAX - 1200;
+	std::vector<char> payload(bip::lz_bound(1000));
+	std::vector<char> raw(1000);
+	for (const auto block : {data.data() + data.size() - 1000, data.data() + data.size() - 1000, data.data()}) {
+		const auto size = bip::lz_compress(block, raw.size(), payload.data(), table.data(), base);
+		if (!bip::lz_decompress(payload.data(), size, raw.data(), raw.size())
+				|| !std::equal(std::begin(raw), std::end(raw), block)) {
+			return false;
+		}
+	}
+	if (base != 2000) {
+		return false;
+	}
+
+	// A frame claiming an empty payload, staged across reads, fails rather than waits.
+	const char empty_frame[bip::lz_header] = {10, 0, 0, 0, 0, 0, 0, 0};
+	bip::LzDecompressor strict{1000};
+	for (size_t i = 0; i < sizeof(empty_frame) && !strict.failed(); ++i) {
+		mid.put(empty_frame + i, 1);
+		strict.decompress(mid, out);
+	}
+	for (size_t i = 0; i < 4 && !strict.failed(); ++i) {
+		strict.decompress(mid, out);
+	}
+	return strict.failed();
+}
+
+static bip::Summary reference_summary(std::deque<double>::const_iterator begin, std::deque<double>::const_iterator end) {
+	bip::Summary result;
+	for (auto i = begin; i != end; ++i) {
+		result.sum += *i;
+		result.min = std::min(result.min, *i);
+		result.max = std::max(result.max, *i);
+		++result.count;
+	}
+	return result;
+}
+
+static bool same_summary(const bip::Summary& l, const bip::Summary& r) {
+	// Integral samples add up exactly.
+	return l.count == r.count && l.sum == r.sum && (l.count == 0 || (l.min == r.min && l.max == r.max));
+}
+
+static bool test_aggregate(const std::vector<elem_type>& in_data) {
+	// All readable elements, then only the last few of them.
+	bool wrapped = false;
+	for (const size_t length : {std::numeric_limits<size_t>::max(), size_t{10}}) {
+		std::array<double, 64> buf;
+		bip::BIP<double> bip{buf.data(), buf.size()};
+		bip::Window<double> window{bip, length};
+		std::deque<double> expected;
+		for (size_t i = 0, next = 0; i < 2000; ++i) {
+			double chunk[13];
+			const auto size = 1 + i % 13;
+			for (size_t j = 0; j < size; ++j) {
+				chunk[j] = in_data[(next + j) % in_data.size()];
+			}
+			const auto written = window.put(chunk, size);
+			expected.insert(std::end(expected), chunk, chunk + written);
+			next += written;
+			const auto read = i % 2 ? window.get(chunk, 1 + i % 11) : window.skip(1 + i % 7);
+			expected.erase(std::begin(expected), std::begin(expected) + read);
+
+			// Both readable regions, in order, across the partition switch.
+			const double* first = nullptr;
+			const double* second = nullptr;
+			size_t first_size = 0;
+			size_t second_size = 0;
+			if (bip.peek(first, first_size, second, second_size) != expected.size() || bip.size() != expected.size() ||
+					!std::equal(first, first + first_size, std::begin(expected)) ||
+					!std::equal(second, second + second_size, std::begin(expected) + first_size)) {
+				return false;
+			}
+			wrapped = wrapped || second_size != 0;
+
+			const auto in_window = std::min(expected.size(), length);
+			const auto last = std::min<size_t>(expected.size(), 1 + i % 40);
+			if (!same_summary(window.summary(), reference_summary(std::end(expected) - in_window, std::end(expected))) ||
+					!same_summary(bip::summarize(bip), reference_summary(std::begin(expected), std::end(expected))) ||
+					!same_summary(bip::summarize(bip, last), reference_summary(std::end(expected) - last, std::end(expected)))) {
+				return false;
+			}
+		}
+	}
+
+	// The generic kernel, with a tail shorter than its unrolling.
+	std::vector<int> ints(std::begin(in_data), std::begin(in_data) + 103);
+	const std::deque<double> as_doubles(std::begin(ints), std::end(ints));
+	return wrapped && same_summary(bip::summarize(ints.data(), ints.size()),
+			reference_summary(std::begin(as_doubles), std::end(as_doubles)));
+}
+
+static bool test_realtime(const std::vector<elem_type>& in_data) {
+	// Locking may exceed RLIMIT_MEMLOCK in test environments.
+	bip::Realtime<elem_type> source{in_data.size() + 1, false};
+	bip::Realtime<elem_type> realtime{buf_size, false};
+	if (source.producer().put(in_data.data(), in_data.size()) != in_data.size()) {
+		return false;
+	}
+
+	// The real-time thread only has its handles, and busy waits when the output is full.
+	using Consumer = bip::Realtime<elem_type>::Consumer;
+	using Producer = bip::Realtime<elem_type>::Producer;
+	auto relay_thr = bip::realtime_thread([](Consumer in, Producer out) noexcept {
+		for (;;) {
+			size_t avail = 0;
+			const auto data = in.peek(avail);
+			if (avail == 0) {
+				return;
+			}
+			in.skip(out.put(data, avail));
+		}
+	}, source.consumer(), realtime.producer());
+
+	auto consumer = realtime.consumer();
+	std::vector<elem_type> out_data;
+	elem_type chunk[max_consume_len];
+	while (out_data.size() < in_data.size()) {
+		const auto read = consumer.get(chunk, sizeof(chunk) / sizeof(chunk[0]));
+		if (read == 0) {
+			std::this_thread::yield();
+		}
+		out_data.insert(std::end(out_data), chunk, chunk + read);
+	}
+	relay_thr.join();
+	if (out_data != in_data) {
+		return false;
+	}
+
+	// Committing past the reserved region publishes only what the region holds.
+	auto producer = realtime.producer();
+	size_t reserved = 0;
+	producer.reserve(reserved);
+	return producer.commit(reserved + 10) == reserved && consumer.avail() == reserved;
+}
+
+/*
+ * Allocator counting the bytes it holds out, to check where a container's storage comes from
+ */
+template <typename T>
+struct Counting {
+	using value_type = T;
+
+	explicit Counting(size_t* held) noexcept : held{held} {}
+
+	template <typename U>
+	Counting(const Counting<U>& other) noexcept : held{other.held} {}
+
+	T* allocate(size_t n) {
+		*held += n * sizeof(T);
+		return std::allocator<T>{}.allocate(n);
+	}
+
+	void deallocate(T* p, size_t n) noexcept {
+		*held -= n * sizeof(T);
+		std::allocator<T>{}.deallocate(p, n);
+	}
+
+	size_t* held;
+};
+
+template <typename T, typename U>
+bool operator==(const Counting<T>& l, const Counting<U>& r) noexcept {
+	return l.held == r.held;
+}
+
+template <typename T, typename U>
+bool operator!=(const Counting<T>& l, const Counting<U>& r) noexcept {
+	return !(l == r);
+}
+
+static bool test_chain(const std::vector<elem_type>& in_data) {
+	bip::Chain<elem_type> chain{buf_size};
+	std::vector<elem_type> out_data;
+	elem_type chunk[max_consume_len];
+	size_t written = 0;
+	size_t most = 0;
+	// Write faster than reading so that the chain grows, then drain it.
+	while (out_data.size() < in_data.size()) {
+		if (written < in_data.size()) {
+			const auto size = std::min<size_t>(in_data.size() - written, max_produce_len);
+			if (chain.put(in_data.data() + written, size) != size) {
+				return false;
+			}
+			written += size;
+		}
+		most = std::max(most, chain.segments());
+		const auto read = chain.get(chunk, sizeof(chunk) / sizeof(chunk[0]) / 2);
+		out_data.insert(std::end(out_data), chunk, chunk + read);
+	}
+
+	bip::Chain<elem_type> bounded{buf_size, 2};
+	const auto accepted = bounded.put(in_data.data(), in_data.size());
+
+	bip::Buffer<elem_type> buffer{buf_size};
+	const auto put = buffer.put(in_data.data(), in_data.size());
+	if (out_data != in_data || !chain.empty() || chain.segments() != 1 || most <= 1 ||
+			accepted != 2 * buf_size || bounded.size() != accepted || put != buffer.capacity()) {
+		return false;
+	}
+
+	// Segments, storage included, come from the supplied allocator and all go back to it.
+	size_t held = 0;
+	{
+		bip::Chain<elem_type, Counting<elem_type>> counted{buf_size, 0, Counting<elem_type>{&held}};
+		counted.put(in_data.data(), 3 * buf_size);
+		if (held < 3 * buf_size * sizeof(elem_type)) {
+			return false;
+		}
+	}
+	bool thrown = false;
+	try {
+		bip::Chain<elem_type> empty{0};
+	} catch (const std::invalid_argument&) {
+		thrown = true;
+	}
+	return held == 0 && thrown;
+}
+
+static bool test_tenants(const std::vector<elem_type>& in_data) {
+	std::array<char, buf_size> buf;
+	bip::BIP<char> bip{buf.data(), buf.size()};
+	bip::Tenants tenants{bip, 3, buf_size / 3};
+
+	using Status = bip::Tenants::Status;
+
+	// A noisy tenant is held to its quota and the others still get in.
+	size_t noisy = 0;
+	auto status = Status::Written;
+	while ((status = tenants.put(0, in_data.data(), 10)) == Status::Written) {
+		++noisy;
+	}
+	if (noisy == 0 || status != Status::OverQuota || tenants.refused(0) != 1 || tenants.used(0) > tenants.quota(0) ||
+			tenants.put(1, in_data.data(), 10) != Status::Written) {
+		return false;
+	}
+
+	// Records that could never fit, empty records and unknown tenants fail apart from quota refusals, without charging anyone.
+	std::vector<elem_type> large(buf_size);
+	if (tenants.put(2, large.data(), large.size()) != Status::TooLarge || tenants.put(3, in_data.data(), 10) != Status::BadTenant ||
+			tenants.put(2, in_data.data(), 0) != Status::Empty || tenants.refused(2) != 0 || tenants.used(2) != 0) {
+		return false;
+	}
+	std::vector<elem_type> record(max_consume_len);
+	size_t tenant = 0;
+	while (tenants.get(record.data(), record.size(), tenant)) {
+	}
+	if (tenants.used(0) != 0 || tenants.used(1) != 0 || !tenants.empty()) {
+		return false;
+	}
+
+	// Records of every size across partition switches, read back in order and credited to their tenants.
+	std::vector<elem_type> out_data;
+	size_t written = 0;
+	for (size_t i = 0; written < in_data.size(); ++i) {
+		const auto size = std::min<size_t>(in_data.size() - written, 1 + i % 29);
+		if (tenants.put(i % 3, in_data.data() + written, size) == Status::Written) {
+			written += size;
+		}
+		if (i % 2) {
+			const auto read = tenants.get(record.data(), record.size(), tenant);
+			out_data.insert(std::end(out_data), record.data(), record.data() + read);
+		}
+	}
+	while (const auto read = tenants.get(record.data(), record.size(), tenant)) {
+		out_data.insert(std::end(out_data), record.data(), record.data() + read);
+	}
+	if (out_data != in_data || tenants.used(0) + tenants.used(1) + tenants.used(2) != 0) {
+		return false;
+	}
+
+	// A full buffer isn't a quota refusal.
+	bip::Tenants roomy{bip, 1, 2 * buf_size};
+	while ((status = roomy.put(0, in_data.data(), 10)) == Status::Written) {
+	}
+	if (status != Status::Full || roomy.refused(0) != 0) {
+		return false;
+	}
+
+	// Buffers holding data already, and more tenants than tags tell apart, are refused.
+	std::array<char, buf_size> spare;
+	bip::BIP<char> empty{spare.data(), spare.size()};
+	size_t thrown = 0;
+	for (auto target : {&bip, &empty}) {
+		try {
+			bip::Tenants refused{*target, target == &bip ? 1 : std::size_t{UINT32_MAX} + 1, buf_size};
+		} catch (const std::invalid_argument&) {
+			++thrown;
+		}
+	}
+	return thrown == 2;
+}
+
+static bool test_batched(const std::vector<elem_type>& in_data) {
+	constexpr size_t batch = 16;
+	std::array<elem_type, buf_size> buf;
+	bip::BIP<elem_type> bip{buf.data(), buf.size()};
+	bip::Blocking<elem_type> blocking{bip, 64, batch};
+
+	std::thread produce_thr([&]() {
+		blocking.put(in_data.data(), in_data.size());
+		blocking.close();
+	});
+
+	std::vector<elem_type> out_data;
+	bool bounded = true;
+	for (size_t i = 0; ; ++i) {
+		// Alternate between copying and in place reads.
+		if (i % 2) {
+			elem_type chunk[max_consume_len];
+			const auto read = blocking.get(chunk, sizeof(chunk) / sizeof(chunk[0]));
+			if (read == 0) {
+				break;
+			}
+			bounded = bounded && read <= batch;
+			out_data.insert(std::end(out_data), chunk, chunk + read);
+		} else if (!blocking.drain([&](const elem_type* data, size_t size) {
+			bounded = bounded && size <= batch;
+			out_data.insert(std::end(out_data), data, data + size);
+		})) {
+			break;
+		}
+	}
+	produce_thr.join();
+	return bounded && out_data == in_data;
+}
+
+static bool test_group(const std::vector<elem_type>& in_data) {
+	const auto file = tmpfile();
+	if (!file) {
+		return false;
+	}
+	const auto fd = fileno(file);
+	bip::Group<elem_type> group{fd, buf_size};
+	bip::Group<elem_type>::Cursor fast{group, "fast"};
+	bip::Group<elem_type>::Cursor slow{group, "slow", 16};
+	std::vector<elem_type> fast_data;
+	std::vector<elem_type> slow_data;
+	elem_type chunk[max_consume_len];
+	for (size_t written = 0, i = 0; written < in_data.size(); ++i) {
+		written += group.put(in_data.data() + written, std::min<size_t>(in_data.size() - written, 1 + i % 37));
+		fast_data.insert(std::end(fast_data), chunk, chunk + fast.get(chunk, max_consume_len));
+		fast.checkpoint();
+		slow_data.insert(std::end(slow_data), chunk, chunk + slow.get(chunk, 1 + i % 23));
+		// Space is only reclaimed behind the slowest checkpoint.
+		if (group.tail() != slow.checkpointed() || group.head() - group.tail() > buf_size) {
+			return false;
+		}
+	}
+	if (fast_data != in_data || slow.position() - slow.checkpointed() >= 16 ||
+			!std::equal(std::begin(slow_data), std::end(slow_data), std::begin(in_data))) {
+		return false;
+	}
+
+	// A restarted consumer resumes from its last checkpoint, without the one on destruction.
+	const auto checkpoint = slow.checkpointed();
+	const auto child = fork();
+	if (child == 0) {
+		bip::Group<elem_type> reopened{fd};
+		bip::Group<elem_type>::Cursor resumed{reopened, "slow"};
+		bip::Group<elem_type>::Cursor done{reopened, "fast"};
+		std::vector<elem_type> rest(in_data.size());
+		const auto read = resumed.get(rest.data(), rest.size());
+		const bool ok = resumed.position() == in_data.size() && done.empty() &&
+				std::equal(std::begin(rest), std::begin(rest) + read, std::begin(in_data) + checkpoint);
+		_exit(ok ? 0 : 1);
+	}
+	int status = 0;
+	waitpid(child, &status, 0);
+	slow.remove();
+	const bool reclaimed = group.tail() == in_data.size() && group.space() == buf_size;
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || !reclaimed) {
+		return false;
+	}
+
+	// An opener that died holding the lock and claiming every free slot leaves nothing behind.
+	const auto dead = fork();
+	if (dead == 0) {
+		_exit(0);
+	}
+	waitpid(dead, &status, 0);
+	const auto memory = mmap(nullptr, sizeof(bip::internal::GroupHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (memory == MAP_FAILED) {
+		return false;
+	}
+	auto& header = *static_cast<bip::internal::GroupHeader*>(memory);
+	header.opener.store(dead);
+	for (auto& slot : header.slot) {
+		if (slot.state.load() == bip::internal::GroupSlot::free) {
+			slot.owner.store(dead);
+			slot.state.store(bip::internal::GroupSlot::claimed);
+		}
+	}
+	// In a child, so that an opener waiting for the lock forever fails the test instead of hanging it.
+	const auto late = fork();
+	if (late == 0) {
+		alarm(5);
+		try {
+			bip::Group<elem_type> reopened{fd};
+			bip::Group<elem_type>::Cursor cursor{reopened, "late"};
+		} catch (const std::system_error&) {
+			_exit(1);
+		}
+		_exit(0);
+	}
+	if (waitpid(late, &status, 0) != late || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+		return false;
+	}
+
+	// Concurrent opens of one new name agree on a single slot.
+	pid_t twins[4];
+	for (auto& twin : twins) {
+		twin = fork();
+		if (twin == 0) {
+			bip::Group<elem_type> reopened{fd};
+			bip::Group<elem_type>::Cursor cursor{reopened, "twin"};
+			_exit(0);
+		}
+	}
+	bool opened = true;
+	for (const auto twin : twins) {
+		opened = waitpid(twin, &status, 0) == twin && WIFEXITED(status) && WEXITSTATUS(status) == 0 && opened;
+	}
+	size_t named = 0;
+	for (const auto& slot : header.slot) {
+		named += slot.state.load() == bip::internal::GroupSlot::live && strcmp(slot.name, "twin") == 0;
+	}
+	const bool unlocked = header.opener.load() == 0;
+	munmap(memory, sizeof(bip::internal::GroupHeader));
+	fclose(file);
+	return opened && named == 1 && unlocked;
+}
+
+static bool test_utf8() {
+	// Two, three and four byte characters straddling the partition switches of a small buffer.
+	const std::string text = "x\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80\xed\x9f\xbf\xf4\x8f\xbf\xbf plain ascii run!";
+	std::array<char, 23> buf;
+	bip::BIP<char> bip{buf.data(), buf.size()};
+	bip::Utf8Writer writer{bip};
+	std::string expected;
+	std::string result;
+	for (size_t i = 0; i < 20; ++i) {
+		expected += text;
+	}
+	// Pieces split characters anywhere.
+	for (size_t written = 0, i = 0; written < expected.size(); ++i) {
+		written += writer.put(expected.data() + written, std::min(expected.size() - written, 1 + i % 7));
+		char out[8];
+		result.append(out, bip.get(out, 1 + i % sizeof(out)));
+		if (!writer.valid() || writer.validated() > written || written - writer.validated() > 3) {
+			return false;
+		}
+	}
+	char out[buf.size()];
+	result.append(out, bip.get(out, sizeof(out)));
+	result.append(out, bip.get(out, sizeof(out)));
+	if (result != expected || writer.validated() != expected.size() || !writer.validator().complete()) {
+		return false;
+	}
+
+	// Overlong, surrogate, past U+10FFFF, stray continuation and a byte that can't start a character.
+	const std::string invalid[] = {"ab\xc0\x80", "ab\xed\xa0\x80", "ab\xf4\x90\x80\x80", "ab\x80", "ab\xe2\x82" "c", "ab\xff"};
+	for (const auto& bad : invalid) {
+		bip::Utf8Validator validator;
+		for (const auto c : bad) {
+			validator.feed(&c, 1);
+		}
+		if (validator.valid() || validator.validated() != 2 || validator.error() < 2) {
+			return false;
+		}
+
+		// The writer commits up to the invalid byte and nothing after.
+		std::array<char, 16> small;
+		bip::BIP<char> target{small.data(), small.size()};
+		bip::Utf8Writer checked{target};
+		if (checked.put(bad.data(), bad.size()) != validator.error() || checked.put("ok", 2) != 0 ||
+				target.size() != validator.error() || checked.validated() != 2) {
+			return false;
+		}
+	}
+	bip::Utf8Validator truncated;
+	return truncated.feed(text.data(), 5) && !truncated.complete() && truncated.validated() == 3;
+}
+
+static bool test_file() {
+	std::array<char, buf_size> buf;
+	bip::BIP<char> bip{buf.data(), buf.size()};
+	const auto out = bip::open_file(bip);
+	if (!out) {
+		return false;
+	}
+	fprintf(out, "%s %d", "seventeen", 17);
+	char text[buf_size + 1] = {};
+	const auto read = bip.get(text, buf_size);
+	const bool formatted = read == 12 && std::string{text, read} == "seventeen 17";
+	// Past the free space, writes fail.
+	const std::string line(buf_size - 10, 'x');
+	const bool overflow = fputs(line.c_str(), out) >= 0 && fputs(line.c_str(), out) == EOF && ferror(out);
+	fclose(out);
+
+	const auto in = bip::open_file(bip, "r");
+	if (!in) {
+		return false;
+	}
+	size_t total = 0;
+	while (fgets(text, sizeof(text), in)) {
+		total += strlen(text);
+	}
+	const bool drained = feof(in) && bip.empty();
+	fclose(in);
+	return formatted && overflow && drained && total >= line.size();
+}
+
+static bool test_direct(const std::vector<elem_type>& in_data) {
+	char path[] = "/tmp/bip_direct_XXXXXX";
+	const auto fd = mkstemp(path);
+	if (fd < 0) {
+		return false;
+	}
+	close(fd);
+
+	alignas(4096) static elem_type storage[4 * 4096];
+	bip::BIP<elem_type> bip{storage, sizeof(storage)};
+	std::vector<elem_type> data;
+	{
+		bip::DirectWriter writer{path, 64 * 1024};
+		for (int i = 0; i < 20; ++i) {
+			for (size_t written = 0; written < in_data.size();) {
+				written += bip.put(in_data.data() + written, in_data.size() - written);
+				writer.drain(bip);
+			}
+			data.insert(std::end(data), std::begin(in_data), std::end(in_data));
+			if (i == 10) {
+				// The partial tail block is written now and again once more data follows.
+				writer.flush();
+			}
+		}
+		writer.drain(bip);
+		if (writer.written() != data.size()) {
+			return false;
+		}
+	}
+
+	std::vector<elem_type> out_data(data.size() + 1);
+	const auto file = fopen(path, "rb");
+	const auto read = file ? fread(out_data.data(), 1, out_data.size(), file) : 0;
+	if (file) {
+		fclose(file);
+	}
+	unlink(path);
+	out_data.resize(read);
+	return out_data == data;
+}
+
+static bool test_mapped(const std::vector<elem_type>& in_data) {
+	const auto file = tmpfile();
+	if (!file) {
+		return false;
+	}
+	// Repeat the data so that the read ahead window slides a few times.
+	std::vector<elem_type> data;
+	for (int i = 0; i < 10; ++i) {
+		data.insert(std::end(data), std::begin(in_data), std::end(in_data));
+	}
+	fwrite(data.data(), sizeof(elem_type), data.size(), file);
+	fflush(file);
+
+	bip::Mapped<elem_type> mapped{fileno(file), 8192};
+	std::vector<elem_type> out_data;
+	elem_type chunk[max_consume_len];
+	while (mapped.have()) {
+		// Alternate between reading in place and copying out.
+		size_t size = 0;
+		const auto in = mapped.peek(size);
+		size = std::min<size_t>(size, 300);
+		out_data.insert(std::end(out_data), in, in + size);
+		mapped.skip(size);
+		const auto read = mapped.get(chunk, sizeof(chunk) / sizeof(chunk[0]));
+		out_data.insert(std::end(out_data), chunk, chunk + read);
+	}
+	fclose(file);
+	return out_data == data && mapped.empty() && mapped.get(chunk, 1) == 0;
+}
+
+static bool test_transfer(const std::vector<elem_type>& in_data) {
+	// Plain buffers of different sizes, so that their partition boundaries fall in different places.
+	std::array<elem_type, buf_size> src_buf;
+	std::array<elem_type, buf_size / 2 + 7> dst_buf;
+	bip::BIP<elem_type> src{src_buf.data(), src_buf.size()};
+	bip::BIP<elem_type> dst{dst_buf.data(), dst_buf.size()};
+	std::vector<elem_type> out_data;
+	elem_type chunk[max_consume_len];
+	for (size_t written = 0; out_data.size() < in_data.size();) {
+		written += src.put(in_data.data() + written, std::min<size_t>(in_data.size() - written, 37));
+		bip::transfer(src, dst, 53);
+		const auto read = dst.get(chunk, 41);
+		out_data.insert(std::end(out_data), chunk, chunk + read);
+	}
+	if (out_data != in_data) {
+		return false;
+	}
+
+	// A router thread between two concurrent buffers.
+	std::array<elem_type, buf_size> in_buf;
+	std::array<elem_type, buf_size> routed_buf;
+	bip::SPSC<elem_type> in{in_buf.data(), in_buf.size()};
+	bip::SPSC<elem_type> routed{routed_buf.data(), routed_buf.size()};
+	std::thread produce_thr([&]() {
+		for (size_t written = 0; written < in_data.size();) {
+			const auto w = in.put(in_data.data() + written, std::min<size_t>(in_data.size() - written, max_produce_len));
+			if (w == 0) {
+				std::this_thread::yield();
+			}
+			written += w;
+		}
+	});
+	std::thread route_thr([&]() {
+		for (size_t moved = 0; moved < in_data.size();) {
+			const auto m = bip::transfer(in, routed, in_data.size() - moved);
+			if (m == 0) {
+				std::this_thread::yield();
+			}
+			moved += m;
+		}
+	});
+	out_data.clear();
+	while (out_data.size() < in_data.size()) {
+		const auto read = routed.get(chunk, sizeof(chunk) / sizeof(chunk[0]));
+		if (read == 0) {
+			std::this_thread::yield();
+		}
+		out_data.insert(std::end(out_data), chunk, chunk + read);
+	}
+	produce_thr.join();
+	route_thr.join();
+	return out_data == in_data;
+}
+
+static bool test_reserved(const std::vector<elem_type>& in_data) {
+	// A gigabyte of address space, of which the data only ever touches the first granule.
+	bip::Reserved<elem_type> reserved{size_t{1} << 30};
+	std::vector<elem_type> out_data;
+	elem_type chunk[max_consume_len];
+	for (size_t written = 0; written < in_data.size();) {
+		written += reserved.put(in_data.data() + written, std::min<size_t>(in_data.size() - written, max_produce_len));
+		const auto read = reserved.get(chunk, sizeof(chunk) / sizeof(chunk[0]));
+		out_data.insert(std::end(out_data), chunk, chunk + read);
+	}
+	while (const auto read = reserved.get(chunk, sizeof(chunk) / sizeof(chunk[0]))) {
+		out_data.insert(std::end(out_data), chunk, chunk + read);
+	}
+	reserved.trim();
+	if (out_data != in_data || reserved.committed() != bip::Reserved<elem_type>::default_granule) {
+		return false;
+	}
+
+	// One put across several granules commits all it needs and lands whole.
+	bip::Reserved<elem_type> wide{size_t{1} << 20};
+	std::vector<elem_type> large(200000);
+	for (size_t i = 0; i < large.size(); ++i) {
+		large[i] = static_cast<elem_type>(in_data[i % in_data.size()]);
+	}
+	std::vector<elem_type> back(large.size());
+	return wide.put(large.data(), large.size()) == large.size() && wide.committed() >= large.size() * sizeof(elem_type) &&
+			wide.get(back.data(), back.size()) == back.size() && back == large;
+}
+
+static bool test_shared(const std::vector<elem_type>& in_data) {
+	const auto file = tmpfile();
+	if (!file) {
+		return false;
+	}
+	const auto fd = fileno(file);
+	bip::Shared<elem_type> shared{fd, buf_size};
+
+	const auto child = fork();
+	if (child == 0) {
+		bip::Shared<elem_type> producer{fd};
+		for (size_t written = 0; written < in_data.size(); written += max_produce_len) {
+			producer.put(in_data.data() + written, std::min<size_t>(in_data.size() - written, max_produce_len));
+		}
+		producer.close();
+		_exit(0);
+	}
+
+	std::vector<elem_type> out_data;
+	elem_type chunk[max_consume_len];
+	while (const auto read = shared.get(chunk, sizeof(chunk) / sizeof(chunk[0]))) {
+		out_data.insert(std::end(out_data), chunk, chunk + read);
+	}
+	int status = 0;
+	waitpid(child, &status, 0);
+	fclose(file);
+	return WIFEXITED(status) && WEXITSTATUS(status) == 0 && out_data == in_data;
+}
+
+struct signal_record {
+	std::uint64_t seq;
+	std::uint64_t check;
+	bool from_handler;
+};
+
+static bip::SignalRing* signal_ring;
+static std::atomic<std::uint64_t> signal_produced;
+
+static void signal_produce(int) {
+	static std::uint64_t seq;
+	const signal_record record{seq, ~seq, true};
+	if (signal_ring->put(&record, sizeof(record))) {
+		++seq;
+		signal_produced.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+static bool test_signal() {
+	alignas(8) static char buf[4096];
+	bip::SignalRing ring{buf, sizeof(buf)};
+	signal_ring = &ring;
+	signal_produced = 0;
+
+	struct sigaction action{};
+	action.sa_handler = signal_produce;
+	sigaction(SIGALRM, &action, nullptr);
+	const itimerval timer{{0, 100}, {0, 100}};
+	setitimer(ITIMER_REAL, &timer, nullptr);
+
+	// Records from the handler interrupt records from this thread.
+	std::atomic<bool> done{false};
+	std::uint64_t consumed = 0;
+	std::uint64_t consumed_handler = 0;
+	bool valid = true;
+	std::thread consume_thr([&]() {
+		signal_record record;
+		for (;;) {
+			const bool last = done;
+			const auto size = ring.get(&record, sizeof(record));
+			if (size == 0) {
+				if (last) {
+					break;
+				}
+				std::this_thread::yield();
+				continue;
+			}
+			valid = valid && size == sizeof(record) && record.check == ~record.seq;
+			++consumed;
+			consumed_handler += record.from_handler;
+		}
+	});
+	std::uint64_t produced = 0;
+	const auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds{200};
+	while (std::chrono::steady_clock::now() < until) {
+		const signal_record record{produced, ~produced, false};
+		produced += ring.put(&record, sizeof(record));
+	}
+
+	const itimerval stop{};
+	setitimer(ITIMER_REAL, &stop, nullptr);
+	signal(SIGALRM, SIG_IGN);
+	done = true;
+	consume_thr.join();
+	return valid && consumed == produced + signal_produced && consumed_handler == signal_produced;
+}
+
+static bool test_rate_limited(const std::vector<elem_type>& in_data) {
+	constexpr double rate = 20000;
+	constexpr double burst = 1000;
+
+	std::array<elem_type, buf_size> buf;
+	bip::BIP<elem_type> bip{buf.data(), buf.size()};
+	bip::Blocking<elem_type> blocking{bip};
+	bip::RateLimited<elem_type> limited{blocking, rate, burst, 100};
+
+	std::thread produce_thr([&]() {
+		blocking.put(in_data.data(), in_data.size());
+		blocking.close();
+	});
+
+	const auto start = std::chrono::steady_clock::now();
+	std::vector<elem_type> out_data;
+	elem_type chunk[max_consume_len];
+	while (auto read = limited.get(chunk, sizeof(chunk) / sizeof(chunk[0]))) {
+		out_data.insert(std::end(out_data), chunk, chunk + read);
+	}
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	produce_thr.join();
+
+	if (out_data != in_data) {
+		std::cerr << "Rate limited data mismatch." << std::endl;
+		return false;
+	}
+	if (elapsed.count() < (in_data.size() - burst) / rate) {
+		std::cerr << "Rate limit exceeded: " << elapsed.count() << "s" << std::endl;
+		return false;
+	}
+
+	// A bucket that can't hold one token would never grant a read.
+	try {
+		bip::RateLimited<elem_type> stuck{blocking, rate, 0.5};
+		return false;
+	} catch (const std::invalid_argument&) {
+	}
+
+	// A burst beyond what a std::size_t counts grants whole requests.
+	bip::TokenBucket vast{rate, 1e30};
+	return vast.take(SIZE_MAX) == SIZE_MAX;
+}
+
+static bool test_lanes(const std::vector<elem_type>& in_data) {
+	std::array<elem_type, buf_size> buf;
+	bip::Lanes<elem_type, 2> lanes{buf.data(), buf.size(), {{1, 3}}, true};
+
+	// The urgent lane borrows the idle bulk lane once its own share is full.
+	auto written = lanes.put(0, in_data.data(), lanes.capacity(0) + 10);
+	if (written != lanes.capacity(0) + 10 || lanes.put(1, in_data.data(), 1) != 0) {
+		std::cerr << "Lane borrowing failed." << std::endl;
+		return false;
+	}
+
+	std::vector<elem_type> out_data(written);
+	std::size_t read = 0;
+	std::size_t lane = 1;
+	while (auto r = lanes.get(out_data.data() + read, written - read, &lane)) {
+		if (lane != 0) {
+			std::cerr << "Lane order mismatch." << std::endl;
+			return false;
+		}
+		read += r;
+	}
+	if (!std::equal(std::begin(out_data), std::end(out_data), std::begin(in_data))) {
+		std::cerr << "Lane data mismatch." << std::endl;
+		return false;
+	}
+
+	// Urgent data overtakes bulk data.
+	lanes.put(1, in_data.data(), 20);
+	lanes.put(0, in_data.data() + 20, 5);
+	elem_type chunk[max_consume_len];
+	if (lanes.get(chunk, sizeof(chunk), &lane) != 5 || lane != 0 || !std::equal(chunk, chunk + 5, in_data.data() + 20)) {
+		std::cerr << "Lane priority mismatch." << std::endl;
+		return false;
+	}
+	if (lanes.get(chunk, sizeof(chunk), &lane) != 20 || lane != 1 || !lanes.empty()) {
+		return false;
+	}
+
+	// Under urgent traffic as fast as the reads, the loan drains once puts go back to the own share, and is returned
+	// for the bulk lane to write again.
+	std::vector<elem_type> urgent_data;
+	std::vector<elem_type> bulk_data;
+	size_t urgent_written = lanes.put(0, in_data.data(), lanes.capacity(0) + 10);
+	size_t bulk_written = 0;
+	for (size_t i = 0; i < 200; ++i) {
+		bulk_written += lanes.put(1, in_data.data() + bulk_written, 1);
+		urgent_written += lanes.put(0, in_data.data() + urgent_written, 8);
+		const auto r = lanes.get(chunk, 8, &lane);
+		auto& out = lane == 0 ? urgent_data : bulk_data;
+		out.insert(std::end(out), chunk, chunk + r);
+	}
+	while (const auto r = lanes.get(chunk, sizeof(chunk), &lane)) {
+		auto& out = lane == 0 ? urgent_data : bulk_data;
+		out.insert(std::end(out), chunk, chunk + r);
+	}
+	if (bulk_written < 100 || bulk_data.size() != bulk_written || urgent_data.size() != urgent_written) {
+		std::cerr << "Lane loan never returned." << std::endl;
+		return false;
+	}
+	return std::equal(std::begin(urgent_data), std::end(urgent_data), std::begin(in_data)) &&
+			std::equal(std::begin(bulk_data), std::end(bulk_data), std::begin(in_data)) && lanes.empty();
+}
+
 int main(int, elem_type**) {
 
 
@@ -115,6 +1173,11 @@ int main(int, elem_type**) {
 
 	auto in_data = generate(data_size);
 
+	if (!test_wrap()) {
+		std::cerr << "Wrap test failed." << std::endl;
+		return 1;
+	}
+
 	std::vector<elem_type> out_data;
 
 	bip::BIP<elem_type> bip{buf.data(), buf.size()};
@@ -142,6 +1205,106 @@ int main(int, elem_type**) {
 		}
 	}
 
+	if (!test_lanes(in_data)) {
+		std::cerr << "Lanes test failed." << std::endl;
+		return 1;
+	}
+
+	if (!test_arena(in_data)) {
+		std::cerr << "Arena test failed." << std::endl;
+		return 1;
+	}
+
+	if (!test_varint(in_data)) {
+		std::cerr << "Varint test failed." << std::endl;
+		return 1;
+	}
+
+	if (!test_columns(in_data)) {
+		std::cerr << "Columns test failed." << std::endl;
+		return 1;
+	}
+
+	if (!test_lz(in_data)) {
+		std::cerr << "LZ test failed." << std::endl;
+		return 1;
+	}
+
+	if (!test_aggregate(in_data)) {
+		std::cerr << "Aggregate test failed." << std::endl;
+		return 1;
+	}
+
+	if (!test_realtime(in_data)) {
+		std::cerr << "Real-time test failed." << std::endl;
+		return 1;
+	}
+
+	if (!test_chain(in_data)) {
+		std::cerr << "Chain test failed." << std::endl;
+		return 1;
+	}
+
+	if (!test_tenants(in_data)) {
+		std::cerr << "Tenant quota test failed." << std::endl;
+		return 1;
+	}
+
+	if (!test_batched(in_data)) {
+		std::cerr << "Bounded batch test failed." << std::endl;
+		return 1;
+	}
+
+	if (!test_group(in_data)) {
+		std::cerr << "Consumer group test failed." << std::endl;
+		return 1;
+	}
+
+	if (!test_utf8()) {
+		std::cerr << "UTF-8 test failed." << std::endl;
+		return 1;
+	}
+
+	if (!test_file()) {
+		std::cerr << "FILE adapter test failed." << std::endl;
+		return 1;
+	}
+
+	if (!test_direct(in_data)) {
+		std::cerr << "Direct write test failed." << std::endl;
+		return 1;
+	}
+
+	if (!test_mapped(in_data)) {
+		std::cerr << "Mapped file test failed." << std::endl;
+		return 1;
+	}
+
+	if (!test_transfer(in_data)) {
+		std::cerr << "Transfer test failed." << std::endl;
+		return 1;
+	}
+
+	if (!test_reserved(in_data)) {
+		std::cerr << "Reserved test failed." << std::endl;
+		return 1;
+	}
+
+	if (!test_shared(in_data)) {
+		std::cerr << "Shared memory test failed." << std::endl;
+		return 1;
+	}
+
+	if (!test_signal()) {
+		std::cerr << "Signal test failed." << std::endl;
+		return 1;
+	}
+
+	if (!test_rate_limited(in_data)) {
+		std::cerr << "Rate limited test failed." << std::endl;
+		return 1;
+	}
+
 	std::cout << "Success" << std::endl;
 	return 0;
 }